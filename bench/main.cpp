@@ -0,0 +1,208 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+// Microbenchmarks for asset ingest: ASSIMP import, mesh processing, texture
+// decoding and upload, and shader source loading.
+//
+// usage: project_base_bench [--filter <substring>] [--min-time <seconds>] [--json <path>]
+//                           [--workers <n>]
+// --workers 0 runs the mesh and texture jobs of model loading inline, for
+// comparison with the default pool. The Model(pak) benchmarks need
+// resources/assets.pak.
+// Run from the repository root so the resources/ paths resolve.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <learnopengl/model.h>
+#include <rg/MicroBench.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+double fileSize(const std::string &path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  return in ? (double)in.tellg() : 0.0;
+}
+
+bool fileExists(const std::string &path) { return (bool)std::ifstream(path); }
+
+unsigned int sceneVertices(const aiScene *scene) {
+  unsigned int vertices = 0;
+  for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+    vertices += scene->mMeshes[i]->mNumVertices;
+  return vertices;
+}
+
+void addModelBenchmarks(rg::MicroBench &suite, const std::string &name,
+                        const std::string &path) {
+  suite.add("Assimp::Importer::ReadFile/" + name, [path](rg::BenchState &state) {
+    if (!fileExists(path))
+      state.skip(path + " not found");
+    double bytes = fileSize(path);
+    while (state.keepRunning()) {
+      Assimp::Importer importer;
+      const aiScene *scene = importer.ReadFile(path, Model::ImportFlags);
+      if (!scene) {
+        state.skip(importer.GetErrorString());
+        continue;
+      }
+      state.addItems(sceneVertices(scene), "vertices");
+      state.addBytes(bytes);
+    }
+  });
+
+  // Builds the meshes of an imported scene: vertex conversion and texture
+  // decoding on the job system, then GPU upload.
+  suite.add("Model::processMesh/" + name, [path](rg::BenchState &state) {
+    Assimp::Importer importer;
+    const aiScene *scene =
+        fileExists(path) ? importer.ReadFile(path, Model::ImportFlags) : nullptr;
+    if (!scene || !scene->mRootNode)
+      state.skip(path + " could not be imported");
+    while (state.keepRunning()) {
+      Model model(scene, path);
+      glFinish();
+      state.addItems(sceneVertices(scene), "vertices");
+      state.pauseTiming();
+      model.Destroy();
+      state.resumeTiming();
+    }
+  });
+
+  // The same model from the asset package: buffers and textures filled
+  // straight from the mapping, no import or decoding.
+  suite.add("Model(pak)/" + name, [path](rg::BenchState &state) {
+    rg::PakBlob blob = rg::pak().find(path);
+    rg::CookedModel cooked(blob);
+    if (!cooked.valid())
+      state.skip(path + " is not in the asset package");
+    // comparable with Model::processMesh: vertices and bytes of the model blob
+    double vertices = 0.0;
+    for (uint32_t i = 0; cooked.valid() && i < cooked.header().MeshCount; i++)
+      vertices += cooked.mesh(i).VertexCount;
+    while (state.keepRunning()) {
+      Model model(path);
+      glFinish();
+      state.addItems(vertices, "vertices");
+      state.addBytes(blob.Size);
+      state.pauseTiming();
+      model.Destroy();
+      state.resumeTiming();
+    }
+  });
+}
+
+void addTextureBenchmark(rg::MicroBench &suite, const std::string &directory,
+                         const std::string &file) {
+  std::string path = directory + "/" + file;
+  suite.add("TextureFromFile/" + file, [directory, file,
+                                        path](rg::BenchState &state) {
+    int width = 0, height = 0, channels = 0;
+    if (!stbi_info(path.c_str(), &width, &height, &channels))
+      state.skip(path + " not found");
+    double bytes = fileSize(path);
+    while (state.keepRunning()) {
+      unsigned int texture = TextureFromFile(file.c_str(), directory);
+      glFinish();
+      state.addItems((double)width * height, "pixels");
+      state.addBytes(bytes);
+      state.pauseTiming();
+      glDeleteTextures(1, &texture);
+      rg::glState().textureDeleted(texture);
+      rg::memoryTracker().textureDeleted(texture);
+      state.resumeTiming();
+    }
+  });
+}
+
+void addShaderSourceBenchmark(rg::MicroBench &suite, const std::string &file) {
+  std::string path = "resources/shaders/" + file;
+  suite.add("readFileContents/" + file, [path](rg::BenchState &state) {
+    if (!fileExists(path))
+      state.skip(path + " not found");
+    while (state.keepRunning()) {
+      std::string source = readFileContents(path);
+      state.addBytes(source.size());
+    }
+  });
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  std::string filter, jsonPath;
+  int workers = -1;
+  rg::MicroBench suite;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+      filter = argv[++i];
+    else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+      jsonPath = argv[++i];
+    else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+      suite.MinSeconds = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+      workers = std::atoi(argv[++i]);
+  }
+  rg::jobs().init(workers);
+
+  // mesh and texture loading create GL objects, so a context is needed
+  glfwInit();
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *window = glfwCreateWindow(64, 64, "bench", nullptr, nullptr);
+  if (window == nullptr) {
+    std::cout << "Failed to create GLFW window" << std::endl;
+    glfwTerminate();
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    std::cout << "Failed to initialize GLAD" << std::endl;
+    return -1;
+  }
+  // same setting the application loads models with
+  stbi_set_flip_vertically_on_load(true);
+  rg::pak().open("resources/assets.pak");
+
+  for (int i = 1; i <= 10; i++) {
+    std::string name = "rb" + std::to_string(i);
+    addModelBenchmarks(suite, name,
+                       "resources/objects/buildings/" + name + ".obj");
+  }
+  addModelBenchmarks(suite, "Shelby", "resources/objects/cobra/Shelby.obj");
+
+  const char *buildingTextures[] = {"AussenWand_C.jpg", "AussenWand_N.jpg",
+                                    "Box_D.jpg", "Steel_C.jpg", "Steel_N.jpg"};
+  for (const char *file : buildingTextures)
+    addTextureBenchmark(suite, "resources/objects/buildings/textures", file);
+  const char *cobraTextures[] = {"Shelby1.png", "Shelby_logo.png",
+                                 "Compteur.png", "scr.jpg"};
+  for (const char *file : cobraTextures)
+    addTextureBenchmark(suite, "resources/objects/cobra", file);
+
+  const char *shaders[] = {"lit.vs", "lit.fs", "include/blinn_phong.glsl",
+                           "framebuffer.fs", "taa.fs", "fxaa.fs"};
+  for (const char *file : shaders)
+    addShaderSourceBenchmark(suite, file);
+
+  suite.run(filter);
+  if (!jsonPath.empty() && !suite.writeJson(jsonPath))
+    std::cout << "Failed to write " << jsonPath << std::endl;
+
+  rg::jobs().shutdown();
+  rg::pak().close();
+  glfwTerminate();
+  return 0;
+}
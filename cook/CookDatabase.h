@@ -0,0 +1,188 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+// What the previous cook read and produced, so a re-run redoes only the assets
+// whose sources or settings changed.
+
+#ifndef PROJECT_BASE_COOKDATABASE_H
+#define PROJECT_BASE_COOKDATABASE_H
+
+#include "ModelCook.h"
+
+#include <rg/Json.h>
+#include <rg/Pak.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace cook {
+
+// FNV-1a of a file's content; false when it cannot be read
+inline bool hashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    hash = 14695981039346656037ull;
+    char buffer[1 << 16];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        for (std::streamsize i = 0; i < in.gcount(); i++) {
+            hash = (hash ^ (unsigned char) buffer[i]) * 1099511628211ull;
+        }
+    }
+    return true;
+}
+
+inline std::string hex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", (unsigned long long) value);
+    return text;
+}
+
+// one cooked blob and everything it was cooked from
+struct CookRecord {
+    std::string Name;
+    // cooker version and settings
+    std::string Key;
+    // files by content hash
+    std::map<std::string, uint64_t> Files;
+    // files that only matter by being there or not, referenced textures
+    std::map<std::string, bool> Existence;
+    // for models, the textures the blob refers to
+    std::vector<TextureUse> Textures;
+};
+
+class CookDatabase {
+public:
+    explicit CookDatabase(std::string directory) : m_Directory(std::move(directory)) {
+    }
+
+    // Reads the records of the last run; a missing or unreadable database
+    // just means everything is cooked.
+    void load() {
+        std::ifstream in(path());
+        if (!in) {
+            return;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        rg::JsonValue root;
+        std::string error;
+        if (!rg::JsonValue::parse(text.str(), root, error)) {
+            std::cerr << path() << ": " << error << ", cooking everything\n";
+            return;
+        }
+        const rg::JsonValue& records = root["records"];
+        for (size_t i = 0; i < records.size(); i++) {
+            const rg::JsonValue& entry = records[i];
+            CookRecord record;
+            record.Name = entry["name"].asString();
+            record.Key = entry["key"].asString();
+            const rg::JsonValue& files = entry["files"];
+            for (size_t f = 0; f < files.size(); f++) {
+                record.Files[files[f][0].asString()] = std::strtoull(files[f][1].asString().c_str(), nullptr, 16);
+            }
+            const rg::JsonValue& existence = entry["exists"];
+            for (size_t f = 0; f < existence.size(); f++) {
+                record.Existence[existence[f][0].asString()] = existence[f][1].asBool();
+            }
+            const rg::JsonValue& textures = entry["textures"];
+            for (size_t t = 0; t < textures.size(); t++) {
+                record.Textures.push_back({textures[t][0].asString(), (rg::CookedTextureSlot) textures[t][1].asNumber()});
+            }
+            m_Records[record.Name] = record;
+        }
+    }
+
+    // Writes records, the ones of this run; assets that are gone drop out.
+    bool save(const std::vector<CookRecord>& records) const {
+        std::ofstream out(path());
+        if (!out) {
+            return false;
+        }
+        out << "{\"records\": [";
+        for (size_t i = 0; i < records.size(); i++) {
+            const CookRecord& record = records[i];
+            out << (i == 0 ? "\n" : ",\n") << "  {\"name\": " << rg::jsonString(record.Name)
+                << ", \"key\": " << rg::jsonString(record.Key) << ",\n   \"files\": [";
+            const char* separator = "";
+            for (const auto& file : record.Files) {
+                out << separator << "[" << rg::jsonString(file.first) << ", \"" << hex(file.second) << "\"]";
+                separator = ", ";
+            }
+            out << "],\n   \"exists\": [";
+            separator = "";
+            for (const auto& file : record.Existence) {
+                out << separator << "[" << rg::jsonString(file.first) << ", " << (file.second ? "true" : "false") << "]";
+                separator = ", ";
+            }
+            out << "],\n   \"textures\": [";
+            separator = "";
+            for (const TextureUse& texture : record.Textures) {
+                out << separator << "[" << rg::jsonString(texture.Name) << ", " << (int) texture.Slot << "]";
+                separator = ", ";
+            }
+            out << "]}";
+        }
+        out << "\n]}\n";
+        return true;
+    }
+
+    // the record of the last run for name, if it is still valid for key
+    const CookRecord* upToDate(const std::string& name, const std::string& key) const {
+        auto found = m_Records.find(name);
+        if (found == m_Records.end() || found->second.Key != key || !fileExists(blobPath(name))) {
+            return nullptr;
+        }
+        const CookRecord& record = found->second;
+        for (const auto& file : record.Files) {
+            uint64_t hash = 0;
+            if (!hashFile(file.first, hash) || hash != file.second) {
+                return nullptr;
+            }
+        }
+        for (const auto& file : record.Existence) {
+            if (fileExists(file.first) != file.second) {
+                return nullptr;
+            }
+        }
+        return &record;
+    }
+
+    // where the blob cooked for name is kept between runs
+    std::string blobPath(const std::string& name) const {
+        return m_Directory + "/" + hex(rg::pakNameHash(name)) + ".blob";
+    }
+
+    // whether the last run cooked exactly these names
+    bool sameNames(const std::vector<CookRecord>& records) const {
+        if (records.size() != m_Records.size()) {
+            return false;
+        }
+        for (const CookRecord& record : records) {
+            if (!m_Records.count(record.Name)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::string m_Directory;
+    std::map<std::string, CookRecord> m_Records;
+
+    std::string path() const {
+        return m_Directory + "/db.json";
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_COOKDATABASE_H
@@ -0,0 +1,225 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+// Model cooking: import, vertex deduplication and cache ordering, quantisation
+// and the Model blob of CookedAssets.h.
+
+#ifndef PROJECT_BASE_MODELCOOK_H
+#define PROJECT_BASE_MODELCOOK_H
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+#include <glm/gtc/packing.hpp>
+
+#include <learnopengl/model.h>
+#include <rg/CookedAssets.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace cook {
+
+inline bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+// a texture a cooked model refers to
+struct TextureUse {
+    std::string Name;
+    rg::CookedTextureSlot Slot;
+};
+
+struct CookedModelResult {
+    std::vector<unsigned char> Blob;
+    // every file the importer opened, the model itself included
+    std::vector<std::string> Sources;
+    // every texture the materials name, whether it exists or not
+    std::vector<std::string> ReferencedTextures;
+    // the ones that exist, in the order the meshes use them
+    std::vector<TextureUse> Textures;
+    std::string Error;
+    size_t Vertices = 0;
+    size_t Indices = 0;
+    bool Packed = false;
+};
+
+// Remembers which files the importer opens, so the .mtl of an .obj or the
+// .bin of a .gltf become dependencies without knowing the formats.
+class RecordingIOSystem : public Assimp::DefaultIOSystem {
+public:
+    explicit RecordingIOSystem(std::vector<std::string>& opened) : m_Opened(opened) {
+    }
+
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override {
+        Assimp::IOStream* stream = DefaultIOSystem::Open(file, mode);
+        if (stream && std::find(m_Opened.begin(), m_Opened.end(), file) == m_Opened.end()) {
+            m_Opened.push_back(file);
+        }
+        return stream;
+    }
+
+private:
+    std::vector<std::string>& m_Opened;
+};
+
+// Renumbers the vertices in the order the indices first use them, so the
+// fetches of a draw walk the vertex buffer forwards. Unused vertices go.
+inline void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::vector<unsigned int> remap(vertices.size(), ~0u);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == ~0u) {
+            remap[index] = ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+inline uint32_t packDirection(const glm::vec3& direction) {
+    glm::vec3 clamped = glm::clamp(direction, glm::vec3(-1.0f), glm::vec3(1.0f));
+    return glm::packSnorm3x10_1x2(glm::vec4(clamped, 0.0f));
+}
+
+inline PackedVertex packVertex(const Vertex& vertex) {
+    PackedVertex packed;
+    packed.Position = vertex.Position;
+    packed.Normal = packDirection(vertex.Normal);
+    packed.TexCoords = glm::packUnorm2x16(vertex.TexCoords);
+    packed.Tangent = packDirection(vertex.Tangent);
+    packed.Bitangent = packDirection(vertex.Bitangent);
+    return packed;
+}
+
+template <typename T>
+void append(std::vector<unsigned char>& blob, const T* data, size_t count) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    blob.insert(blob.end(), bytes, bytes + count * sizeof(T));
+}
+
+inline void alignTo16(std::vector<unsigned char>& blob) {
+    blob.resize((blob.size() + 15) / 16 * 16);
+}
+
+// Imports path the way Model does and builds its Model blob.
+inline bool cookModel(const std::string& path, CookedModelResult& result) {
+    Assimp::Importer importer;
+    importer.SetIOHandler(new RecordingIOSystem(result.Sources));
+    // on top of what the application does: one vertex per distinct attribute
+    // set, and triangles ordered for the post-transform vertex cache
+    const aiScene* scene = importer.ReadFile(path, Model::ImportFlags | aiProcess_JoinIdenticalVertices |
+                                                   aiProcess_ImproveCacheLocality);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        result.Error = importer.GetErrorString();
+        return false;
+    }
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    // meshes in the order Model draws them
+    std::vector<const aiMesh*> sceneMeshes;
+    std::vector<const aiNode*> nodes = {scene->mRootNode};
+    while (!nodes.empty()) {
+        const aiNode* node = nodes.back();
+        nodes.pop_back();
+        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+            sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+        }
+        for (unsigned int i = node->mNumChildren; i > 0; i--) {
+            nodes.push_back(node->mChildren[i - 1]);
+        }
+    }
+
+    std::vector<rg::CookedMesh> meshes(sceneMeshes.size());
+    std::vector<rg::CookedTextureRef> refs;
+    std::vector<std::vector<Vertex>> vertices(sceneMeshes.size());
+    std::vector<std::vector<unsigned int>> indices(sceneMeshes.size());
+    bool packable = true;
+    for (size_t i = 0; i < sceneMeshes.size(); i++) {
+        Model::processMesh(sceneMeshes[i], vertices[i], indices[i]);
+        optimizeVertexFetch(vertices[i], indices[i]);
+        for (const Vertex& vertex : vertices[i]) {
+            packable = packable && vertex.TexCoords.x >= 0.0f && vertex.TexCoords.x <= 1.0f &&
+                       vertex.TexCoords.y >= 0.0f && vertex.TexCoords.y <= 1.0f;
+        }
+
+        const aiMaterial* material = scene->mMaterials[sceneMeshes[i]->mMaterialIndex];
+        rg::CookedMesh& mesh = meshes[i];
+        mesh.VertexCount = vertices[i].size();
+        mesh.IndexCount = indices[i].size();
+        mesh.FirstTextureRef = refs.size();
+        mesh.Params = Model::materialParams(material);
+        for (size_t slot = 0; slot < Model::textureSlots().size(); slot++) {
+            aiTextureType type = Model::textureSlots()[slot].first;
+            for (unsigned int t = 0; t < material->GetTextureCount(type); t++) {
+                aiString file;
+                material->GetTexture(type, t, &file);
+                // embedded textures ("*0") are not supported by Model either
+                if (file.C_Str()[0] == '*') {
+                    continue;
+                }
+                std::string name = directory + '/' + file.C_Str();
+                if (std::find(result.ReferencedTextures.begin(), result.ReferencedTextures.end(), name) ==
+                    result.ReferencedTextures.end()) {
+                    result.ReferencedTextures.push_back(name);
+                }
+                // a missing file leaves the map out and the material colour in
+                if (!fileExists(name)) {
+                    continue;
+                }
+                rg::CookedTextureRef ref = {};
+                ref.NameHash = rg::pakNameHash(name);
+                ref.Slot = (rg::CookedTextureSlot) slot;
+                refs.push_back(ref);
+                result.Textures.push_back({name, ref.Slot});
+            }
+        }
+        mesh.TextureRefCount = refs.size() - mesh.FirstTextureRef;
+        result.Vertices += mesh.VertexCount;
+        result.Indices += mesh.IndexCount;
+    }
+    result.Packed = packable;
+
+    rg::CookedModelHeader header = {};
+    header.MeshCount = meshes.size();
+    header.TextureRefCount = refs.size();
+    header.VertexFormat = packable ? rg::CookedVertexFormat::Packed : rg::CookedVertexFormat::Float;
+    header.VertexSize = packable ? sizeof(PackedVertex) : sizeof(Vertex);
+
+    // tables first, offsets filled in once the arrays are placed
+    std::vector<unsigned char>& blob = result.Blob;
+    append(blob, &header, 1);
+    size_t meshTable = blob.size();
+    append(blob, meshes.data(), meshes.size());
+    append(blob, refs.data(), refs.size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        alignTo16(blob);
+        meshes[i].VertexOffset = blob.size();
+        if (packable) {
+            std::vector<PackedVertex> packed;
+            packed.reserve(vertices[i].size());
+            for (const Vertex& vertex : vertices[i]) {
+                packed.push_back(packVertex(vertex));
+            }
+            append(blob, packed.data(), packed.size());
+        } else {
+            append(blob, vertices[i].data(), vertices[i].size());
+        }
+        alignTo16(blob);
+        meshes[i].IndexOffset = blob.size();
+        append(blob, indices[i].data(), indices[i].size());
+    }
+    std::memcpy(blob.data() + meshTable, meshes.data(), meshes.size() * sizeof(rg::CookedMesh));
+    return true;
+}
+
+};
+
+#endif //PROJECT_BASE_MODELCOOK_H
@@ -0,0 +1,337 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+// Texture cooking: decode, mip chain, BC1/BC3 (S3TC) block compression and the
+// Texture blob of CookedAssets.h.
+
+#ifndef PROJECT_BASE_TEXTURECOOK_H
+#define PROJECT_BASE_TEXTURECOOK_H
+
+#include <rg/CookedAssets.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace cook {
+
+// how a texture ends up in the package
+enum class TextureEncoding {
+    // base level only, as decoded (cubemap faces)
+    Raw,
+    // as decoded, with the full mip chain
+    RawMips,
+    // BC1, or BC3 when any pixel is not opaque, with the full mip chain
+    Compressed,
+};
+
+struct TextureSettings {
+    TextureEncoding Encoding = TextureEncoding::Compressed;
+    // rows bottom to top, as the application loads model textures
+    bool Flip = false;
+
+    // part of the cache key, changes whenever the output would
+    std::string key() const {
+        return std::to_string((int) Encoding) + (Flip ? "f" : "");
+    }
+};
+
+struct Image {
+    int Width = 0;
+    int Height = 0;
+    int Channels = 0;
+    std::vector<unsigned char> Pixels;
+
+    const unsigned char* pixel(int x, int y) const {
+        return &Pixels[((size_t) y * Width + x) * Channels];
+    }
+};
+
+inline bool loadImage(const std::string& path, bool flip, Image& image) {
+    // stbi's flip setting is global, the rows are flipped here instead so
+    // images can load on any thread
+    unsigned char* data = stbi_load(path.c_str(), &image.Width, &image.Height, &image.Channels, 0);
+    if (!data) {
+        return false;
+    }
+    size_t row = (size_t) image.Width * image.Channels;
+    image.Pixels.resize(row * image.Height);
+    for (int y = 0; y < image.Height; y++) {
+        int source = flip ? image.Height - 1 - y : y;
+        std::memcpy(&image.Pixels[y * row], data + source * row, row);
+    }
+    stbi_image_free(data);
+    return true;
+}
+
+// The next mip level: 2x2 box filter, the last row or column of an odd size
+// folded into its neighbour. Like glGenerateMipmap, filters the stored values.
+inline Image downsample(const Image& image) {
+    Image half;
+    half.Width = std::max(1, image.Width / 2);
+    half.Height = std::max(1, image.Height / 2);
+    half.Channels = image.Channels;
+    half.Pixels.resize((size_t) half.Width * half.Height * half.Channels);
+    for (int y = 0; y < half.Height; y++) {
+        int y0 = std::min(2 * y, image.Height - 1);
+        int y1 = std::min(2 * y + 1, image.Height - 1);
+        for (int x = 0; x < half.Width; x++) {
+            int x0 = std::min(2 * x, image.Width - 1);
+            int x1 = std::min(2 * x + 1, image.Width - 1);
+            for (int c = 0; c < image.Channels; c++) {
+                int sum = image.pixel(x0, y0)[c] + image.pixel(x1, y0)[c] + image.pixel(x0, y1)[c] + image.pixel(x1, y1)[c];
+                half.Pixels[((size_t) y * half.Width + x) * half.Channels + c] = (unsigned char) ((sum + 2) / 4);
+            }
+        }
+    }
+    return half;
+}
+
+// the same pixels with channels channels: grey is copied to RGB, alpha
+// defaults to opaque
+inline Image expand(const Image& image, int channels) {
+    if (image.Channels == channels) {
+        return image;
+    }
+    Image out;
+    out.Width = image.Width;
+    out.Height = image.Height;
+    out.Channels = channels;
+    out.Pixels.resize((size_t) image.Width * image.Height * channels);
+    for (size_t i = 0; i < (size_t) image.Width * image.Height; i++) {
+        const unsigned char* in = &image.Pixels[i * image.Channels];
+        unsigned char rgba[4] = {in[0], in[0], in[0], 255};
+        if (image.Channels >= 3) {
+            rgba[1] = in[1];
+            rgba[2] = in[2];
+        }
+        if (image.Channels == 2 || image.Channels == 4) {
+            rgba[3] = in[image.Channels - 1];
+        }
+        std::memcpy(&out.Pixels[i * channels], rgba, channels);
+    }
+    return out;
+}
+
+namespace bc {
+
+inline uint16_t to565(const float rgb[3]) {
+    int r = (int) std::lround(std::min(std::max(rgb[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+    int g = (int) std::lround(std::min(std::max(rgb[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+    int b = (int) std::lround(std::min(std::max(rgb[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+    return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+inline void from565(uint16_t color, int rgb[3]) {
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Colour half of a BC1/BC3 block, always in four colour mode. The endpoints
+// are the extremes of the pixels along their principal axis.
+inline void encodeColor(const unsigned char pixels[16][4], unsigned char out[8]) {
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            mean[c] += pixels[i][c] / 16.0f;
+        }
+    }
+    float cov[6] = {0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 16; i++) {
+        float d[3] = {pixels[i][0] - mean[0], pixels[i][1] - mean[1], pixels[i][2] - mean[2]};
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+    // power iteration for the dominant eigenvector
+    float axis[3] = {1, 1, 1};
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                         cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                         cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+        float length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::fabs(next[2]));
+        if (length < 1e-6f) {
+            break;
+        }
+        for (int c = 0; c < 3; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+    float low = 1e30f, high = -1e30f;
+    for (int i = 0; i < 16; i++) {
+        float t = (pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1] + (pixels[i][2] - mean[2]) * axis[2];
+        low = std::min(low, t);
+        high = std::max(high, t);
+    }
+    float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; c++) {
+        e0[c] = mean[c] + axis[c] * high / axisLength2;
+        e1[c] = mean[c] + axis[c] * low / axisLength2;
+    }
+    uint16_t c0 = to565(e0), c1 = to565(e1);
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    int palette[4][3];
+    from565(c0, palette[0]);
+    from565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = pixels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= (uint32_t) best << (2 * i);
+        }
+    }
+    out[0] = c0 & 0xff;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xff;
+    out[3] = c1 >> 8;
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (indices >> (8 * i)) & 0xff;
+    }
+}
+
+// alpha half of a BC3 block, eight level mode between the extremes
+inline void encodeAlpha(const unsigned char pixels[16][4], unsigned char out[8]) {
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        a0 = std::max(a0, (int) pixels[i][3]);
+        a1 = std::min(a1, (int) pixels[i][3]);
+    }
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        int palette[8] = {a0, a1};
+        for (int p = 1; p < 7; p++) {
+            palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+        }
+        for (int i = 0; i < 16; i++) {
+            int best = 0;
+            for (int p = 1; p < 8; p++) {
+                if (std::abs(pixels[i][3] - palette[p]) < std::abs(pixels[i][3] - palette[best])) {
+                    best = p;
+                }
+            }
+            indices |= (uint64_t) best << (3 * i);
+        }
+    }
+    out[0] = (unsigned char) a0;
+    out[1] = (unsigned char) a1;
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = (indices >> (8 * i)) & 0xff;
+    }
+}
+
+// RGBA image to BC1 (alpha false) or BC3 blocks, rows of blocks top to bottom
+inline std::vector<unsigned char> encode(const Image& rgba, bool alpha) {
+    int blocksX = (rgba.Width + 3) / 4, blocksY = (rgba.Height + 3) / 4;
+    size_t blockSize = alpha ? 16 : 8;
+    std::vector<unsigned char> out((size_t) blocksX * blocksY * blockSize);
+    unsigned char* block = out.data();
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            // edge blocks repeat the last row and column
+            unsigned char pixels[16][4];
+            for (int i = 0; i < 16; i++) {
+                int x = std::min(bx * 4 + i % 4, rgba.Width - 1);
+                int y = std::min(by * 4 + i / 4, rgba.Height - 1);
+                std::memcpy(pixels[i], rgba.pixel(x, y), 4);
+            }
+            if (alpha) {
+                encodeAlpha(pixels, block);
+                encodeColor(pixels, block + 8);
+            } else {
+                encodeColor(pixels, block);
+            }
+            block += blockSize;
+        }
+    }
+    return out;
+}
+
+};
+
+// The Texture blob for image.
+inline std::vector<unsigned char> cookTexture(const Image& image, const TextureSettings& settings) {
+    static const GLenum formats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    static const GLenum internalFormats[] = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+
+    Image level = image;
+    bool alpha = false;
+    if (settings.Encoding == TextureEncoding::Compressed) {
+        level = expand(image, 4);
+        for (size_t i = 3; i < level.Pixels.size() && !alpha; i += 4) {
+            alpha = level.Pixels[i] != 255;
+        }
+    }
+
+    rg::CookedTextureHeader header = {};
+    header.Width = image.Width;
+    header.Height = image.Height;
+    if (settings.Encoding == TextureEncoding::Compressed) {
+        header.InternalFormat = alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    } else {
+        header.InternalFormat = internalFormats[image.Channels - 1];
+        header.Format = formats[image.Channels - 1];
+        header.Type = GL_UNSIGNED_BYTE;
+    }
+
+    std::vector<rg::CookedTextureLevel> levels;
+    std::vector<std::vector<unsigned char>> data;
+    while (true) {
+        if (settings.Encoding == TextureEncoding::Compressed) {
+            data.push_back(bc::encode(level, alpha));
+        } else {
+            data.push_back(level.Pixels);
+        }
+        levels.push_back({0, data.back().size(), (uint32_t) level.Width, (uint32_t) level.Height});
+        if (settings.Encoding == TextureEncoding::Raw || (level.Width == 1 && level.Height == 1)) {
+            break;
+        }
+        level = downsample(level);
+    }
+    header.Levels = levels.size();
+
+    size_t offset = sizeof(header) + levels.size() * sizeof(rg::CookedTextureLevel);
+    offset = (offset + 15) / 16 * 16;
+    for (rg::CookedTextureLevel& l : levels) {
+        l.Offset = offset;
+        offset += l.Size;
+    }
+    std::vector<unsigned char> blob(offset);
+    std::memcpy(blob.data(), &header, sizeof(header));
+    std::memcpy(blob.data() + sizeof(header), levels.data(), levels.size() * sizeof(rg::CookedTextureLevel));
+    for (size_t i = 0; i < levels.size(); i++) {
+        std::memcpy(blob.data() + levels[i].Offset, data[i].data(), data[i].size());
+    }
+    return blob;
+}
+
+};
+
+#endif //PROJECT_BASE_TEXTURECOOK_H
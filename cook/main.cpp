@@ -0,0 +1,323 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+// Cooks resources/ into the asset package the application loads
+// (resources/assets.pak, see rg::PakFile):
+//   models under objects/ (.obj, .gltf, .glb): imported with Assimp like Model
+//     does, identical vertices merged, triangles ordered for the vertex cache,
+//     vertices renumbered in fetch order and packed to half size where the
+//     texture coordinates allow it,
+//   the textures they use: full mip chains, BC1/BC3 for colour and specular
+//     maps, uncompressed for normal maps,
+//   images under textures/ (the skybox faces): base level, uncompressed.
+// Sources the models reference but the resources do not have are left out,
+// the meshes then use their material colours.
+//
+// A database in the cache directory keeps the content hash of every source of
+// every blob, so a re-run cooks only what changed; the package is rewritten
+// only when something did. Cooking runs on all cores.
+//
+// usage: asset_cook [--resources <dir>] [--out <pak>] [--cache <dir>]
+//                   [--workers <n>] [--force]
+// Run from the repository root, which `make cook_assets` does: names in the
+// package are the paths the application opens, e.g.
+// "resources/objects/cobra/Shelby.obj".
+
+#include "CookDatabase.h"
+#include "ModelCook.h"
+#include "TextureCook.h"
+
+#include <rg/JobSystem.h>
+#include <rg/Pak.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// bump whenever the cooked output changes for the same sources
+const char *kCookVersion = "1";
+
+std::mutex logMutex;
+
+template <typename... Args> void log(const Args &...args) {
+  std::lock_guard<std::mutex> lock(logMutex);
+  using expand = int[];
+  (void)expand{0, ((std::cout << args), 0)...};
+  std::cout << std::endl;
+}
+
+std::string lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return text;
+}
+
+// regular files below directory with one of extensions, sorted, hidden
+// entries skipped
+void walk(const std::string &directory,
+          const std::vector<std::string> &extensions,
+          std::vector<std::string> &files) {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+  std::vector<std::string> names;
+  while (dirent *entry = readdir(dir))
+    if (entry->d_name[0] != '.')
+      names.push_back(entry->d_name);
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  for (const std::string &name : names) {
+    std::string path = directory + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+      continue;
+    if (S_ISDIR(info.st_mode)) {
+      walk(path, extensions, files);
+      continue;
+    }
+    std::string extension = lowercase(name.substr(name.find_last_of('.') + 1));
+    if (std::find(extensions.begin(), extensions.end(), extension) !=
+        extensions.end())
+      files.push_back(path);
+  }
+}
+
+bool writeFile(const std::string &path,
+               const std::vector<unsigned char> &data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write((const char *)data.data(), data.size());
+  return (bool)out;
+}
+
+bool readFile(const std::string &path, std::vector<unsigned char> &data) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in)
+    return false;
+  data.resize(in.tellg());
+  in.seekg(0);
+  return (bool)in.read((char *)data.data(), data.size());
+}
+
+// one blob of the package and how this run got it
+struct Asset {
+  rg::PakBlobType Type;
+  cook::TextureSettings Settings;
+  cook::CookRecord Record;
+  bool Cooked = false;
+  bool Failed = false;
+};
+
+void cookModelAsset(Asset &asset, const cook::CookDatabase &db) {
+  const std::string &name = asset.Record.Name;
+  cook::CookedModelResult result;
+  if (!cook::cookModel(name, result)) {
+    log("failed  ", name, ": ", result.Error);
+    asset.Failed = true;
+    return;
+  }
+  for (const std::string &source : result.Sources) {
+    uint64_t hash = 0;
+    if (cook::hashFile(source, hash))
+      asset.Record.Files[source] = hash;
+  }
+  for (const std::string &texture : result.ReferencedTextures)
+    asset.Record.Existence[texture] = cook::fileExists(texture);
+  asset.Record.Textures = result.Textures;
+  if (!writeFile(db.blobPath(name), result.Blob)) {
+    log("failed  ", name, ": cannot write ", db.blobPath(name));
+    asset.Failed = true;
+    return;
+  }
+  asset.Cooked = true;
+  log("cooked  ", name, ": ", result.Vertices, " vertices",
+      result.Packed ? " (packed)" : "", ", ", result.Indices / 3,
+      " triangles, ", result.Blob.size() / 1024, " KB");
+}
+
+void cookTextureAsset(Asset &asset, const cook::CookDatabase &db) {
+  const std::string &name = asset.Record.Name;
+  cook::Image image;
+  uint64_t hash = 0;
+  if (!cook::hashFile(name, hash) ||
+      !cook::loadImage(name, asset.Settings.Flip, image)) {
+    log("failed  ", name, ": ", stbi_failure_reason());
+    asset.Failed = true;
+    return;
+  }
+  asset.Record.Files[name] = hash;
+  std::vector<unsigned char> blob = cook::cookTexture(image, asset.Settings);
+  if (!writeFile(db.blobPath(name), blob)) {
+    log("failed  ", name, ": cannot write ", db.blobPath(name));
+    asset.Failed = true;
+    return;
+  }
+  asset.Cooked = true;
+  log("cooked  ", name, ": ", image.Width, "x", image.Height, ", ",
+      blob.size() / 1024, " KB");
+}
+
+// Runs cook on every asset the database has no valid record for, in parallel.
+void cookAll(std::vector<Asset> &assets, const cook::CookDatabase &db,
+             void (*cook)(Asset &, const cook::CookDatabase &)) {
+  rg::JobCounter counter;
+  for (Asset &asset : assets) {
+    rg::jobs().run("Cook asset", [&asset, &db, cook] {
+      std::string key = kCookVersion;
+      if (asset.Type == rg::PakBlobType::Texture)
+        key += "/" + asset.Settings.key();
+      if (const cook::CookRecord *record =
+              db.upToDate(asset.Record.Name, key)) {
+        asset.Record = *record;
+        return;
+      }
+      asset.Record.Key = key;
+      cook(asset, db);
+    }, &counter);
+  }
+  rg::jobs().wait(counter);
+}
+
+Asset makeAsset(const std::string &name, rg::PakBlobType type) {
+  Asset asset;
+  asset.Type = type;
+  asset.Record.Name = name;
+  return asset;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) -> int {
+  std::string resources = "resources", output = "resources/assets.pak";
+  std::string cache = "resources/.cook";
+  int workers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+  bool force = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--resources") == 0 && i + 1 < argc)
+      resources = argv[++i];
+    else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+      output = argv[++i];
+    else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+      cache = argv[++i];
+    else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+      workers = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--force") == 0)
+      force = true;
+  }
+  auto start = std::chrono::steady_clock::now();
+  mkdir(cache.c_str(), 0755);
+  cook::CookDatabase db(cache);
+  if (!force)
+    db.load();
+  rg::jobs().init(workers);
+
+  std::vector<std::string> modelPaths, imagePaths;
+  walk(resources + "/objects", {"obj", "gltf", "glb"}, modelPaths);
+  walk(resources + "/textures", {"jpg", "jpeg", "png", "tga", "bmp"},
+       imagePaths);
+
+  std::vector<Asset> models;
+  for (const std::string &path : modelPaths)
+    models.push_back(makeAsset(path, rg::PakBlobType::Model));
+  cookAll(models, db, cookModelAsset);
+
+  // Textures of the models, flipped like Model loads them. A texture used as
+  // a normal map anywhere stays uncompressed.
+  std::vector<Asset> textures;
+  for (const Asset &model : models) {
+    if (model.Failed)
+      continue;
+    for (const cook::TextureUse &use : model.Record.Textures) {
+      auto same = [&use](const Asset &asset) {
+        return asset.Record.Name == use.Name;
+      };
+      auto texture = std::find_if(textures.begin(), textures.end(), same);
+      if (texture == textures.end()) {
+        textures.push_back(makeAsset(use.Name, rg::PakBlobType::Texture));
+        texture = textures.end() - 1;
+        texture->Settings.Flip = true;
+      }
+      if (use.Slot == rg::CookedTextureSlot::Normal ||
+          use.Slot == rg::CookedTextureSlot::Height)
+        texture->Settings.Encoding = cook::TextureEncoding::RawMips;
+    }
+  }
+  size_t modelTextures = textures.size();
+  for (const std::string &path : imagePaths) {
+    textures.push_back(makeAsset(path, rg::PakBlobType::Texture));
+    textures.back().Settings.Encoding = cook::TextureEncoding::Raw;
+  }
+  cookAll(textures, db, cookTextureAsset);
+
+  // Package order is load order: each model followed by the textures it is
+  // the first to use, then the images loaded on their own.
+  std::vector<const Asset *> order;
+  for (const Asset &model : models) {
+    if (model.Failed)
+      continue;
+    order.push_back(&model);
+    for (size_t i = 0; i < modelTextures; i++)
+      if (std::find(order.begin(), order.end(), &textures[i]) == order.end() &&
+          std::any_of(model.Record.Textures.begin(),
+                      model.Record.Textures.end(),
+                      [&](const cook::TextureUse &use) {
+                        return use.Name == textures[i].Record.Name;
+                      }))
+        order.push_back(&textures[i]);
+  }
+  for (size_t i = modelTextures; i < textures.size(); i++)
+    order.push_back(&textures[i]);
+
+  std::vector<cook::CookRecord> records;
+  size_t cooked = 0, failed = 0;
+  for (const Asset *asset : order) {
+    if (asset->Failed) {
+      failed++;
+      continue;
+    }
+    records.push_back(asset->Record);
+    cooked += asset->Cooked;
+  }
+
+  int result = failed > 0 ? 1 : 0;
+  struct stat info;
+  if (cooked == 0 && db.sameNames(records) && stat(output.c_str(), &info) == 0) {
+    std::cout << output << " is up to date" << std::endl;
+  } else {
+    rg::PakWriter writer;
+    for (const cook::CookRecord &record : records) {
+      const Asset *asset = *std::find_if(
+          order.begin(), order.end(),
+          [&](const Asset *a) { return a->Record.Name == record.Name; });
+      std::vector<unsigned char> blob;
+      if (!readFile(db.blobPath(record.Name), blob) ||
+          !writer.add(record.Name, asset->Type, std::move(blob)))
+        result = 1;
+    }
+    if (!writer.write(output))
+      result = 1;
+  }
+  if (!db.save(records))
+    std::cout << "Failed to write the cook database to " << cache << std::endl;
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::cout << records.size() << " assets, " << cooked << " cooked, "
+            << records.size() - cooked << " up to date, " << failed
+            << " failed in " << seconds << " s" << std::endl;
+  rg::jobs().shutdown();
+  return result;
+}
@@ -7,8 +7,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <rg/CommandList.h>
+#include <rg/DrawStats.h>
+#include <rg/GLState.h>
+#include <rg/Material.h>
+#include <rg/MemoryTracker.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
@@ -25,6 +34,17 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// Vertex as the asset cooker packs it, at half the size: normal, tangent and bitangent as signed normalized
+// 10:10:10:2 (GL_INT_2_10_10_10_REV), texture coordinates in [0, 1] as two unsigned normalized shorts, x in the
+// low half. The shaders see the same attributes as with Vertex.
+struct PackedVertex {
+    glm::vec3 Position;
+    uint32_t Normal;
+    uint32_t TexCoords;
+    uint32_t Tangent;
+    uint32_t Bitangent;
+};
+
 
 
 struct Texture {
@@ -35,27 +55,54 @@ struct Texture {
 
 class Mesh {
 public:
-    // mesh Data
+    // mesh Data; vertices and indices are empty unless the model keeps them, see ReleaseCpuGeometry()
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
 
     unsigned int VAO;
+    // number of vertices in the vertex buffer
+    unsigned int vertexCount;
+    // number of indices drawn
+    unsigned int indexCount;
     std::string glslIdentifierPrefix;
+    // maps and parameters for recorded draws, shared with identical meshes
+    const rg::Material *material = nullptr;
+    // bounding sphere in model space and texture coordinate units per model space unit, for texture streaming
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    float uvDensity = 0.0f;
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices.data(), this->vertices.size(), false, this->indices.data(), this->indices.size());
+    }
+
+    // constructor for data that lives elsewhere, e.g. in a mapped asset package: the buffers are filled straight
+    // from it and vertices and indices stay empty
+    Mesh(const Vertex *vertexData, size_t vertexCount, const unsigned int *indexData, size_t indexCount,
+         vector<Texture> textures)
+    {
+        this->textures = textures;
+        setupMesh(vertexData, vertexCount, false, indexData, indexCount);
+    }
+
+    Mesh(const PackedVertex *vertexData, size_t vertexCount, const unsigned int *indexData, size_t indexCount,
+         vector<Texture> textures)
+    {
+        this->textures = textures;
+        setupMesh(vertexData, vertexCount, true, indexData, indexCount);
     }
 
     // render the mesh
     void Draw(Shader &shader)
     {
+        rg::GLState &state = rg::glState();
         // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
@@ -63,7 +110,6 @@ public:
         unsigned int heightNr   = 1;
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -78,19 +124,50 @@ public:
 
             // now set the sampler to the correct texture unit
             glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            // and finally bind the texture to the unit, skipped when it is bound already
+            state.bindTexture(i, GL_TEXTURE_2D, textures[i].id);
         }
 
 
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // draw mesh; bindings are left in place, the next draw of the same mesh then changes nothing
+        state.bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        rg::countDraw(GL_TRIANGLES, indexCount);
+    }
+
+    // records what Draw does into a command list, for the program of the last list.use(); the material binds its
+    // maps to the fixed units of rg::Material
+    void Record(rg::CommandList &list) const
+    {
+        if (material)
+            material->record(list);
+        RecordDraw(list);
+    }
+
+    // records the draw alone, for when the material is bound already
+    void RecordDraw(rg::CommandList &list) const
+    {
+        list.bindVertexArray(VAO);
+        list.drawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT);
+    }
+
+    // frees the CPU copies of vertices and indices once they are on the GPU; counts and bounds stay
+    void ReleaseCpuGeometry()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    // frees the GPU buffers; textures are owned by the model
+    void Destroy()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        rg::glState().vertexArrayDeleted(VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        rg::memoryTracker().bufferDeleted(VBO);
+        rg::memoryTracker().bufferDeleted(EBO);
     }
 
 private:
@@ -98,42 +175,106 @@ private:
     unsigned int VBO, EBO;
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const void *vertexData, size_t vertexCount, bool packed, const unsigned int *indexData,
+                   size_t indexCount)
     {
+        this->vertexCount = vertexCount;
+        this->indexCount = indexCount;
+        computeBounds(vertexData, vertexCount, packed, indexData, indexCount);
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        rg::glState().bindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        size_t vertexBytes = vertexCount * (packed ? sizeof(PackedVertex) : sizeof(Vertex));
+        glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexData, GL_STATIC_DRAW);
+        rg::memoryTracker().bufferAllocated(VBO, vertexBytes, GL_STATIC_DRAW, rg::MemoryCategory::Geometry);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-
-        glBindVertexArray(0);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexData, GL_STATIC_DRAW);
+        rg::memoryTracker().bufferAllocated(EBO, indexCount * sizeof(unsigned int), GL_STATIC_DRAW,
+                                            rg::MemoryCategory::Geometry);
+
+        if (packed)
+        {
+            // the 10:10:10:2 attributes come with a w the shaders ignore
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Normal));
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, TexCoords));
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Tangent));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, Bitangent));
+        }
+        else
+        {
+            // set the vertex attribute pointers
+            // vertex Positions
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // vertex normals
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            // vertex texture coords
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            // vertex tangent
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+            // vertex bitangent
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        }
+
+        rg::glState().bindVertexArray(0);
+    }
+
+    // fills boundsCenter, boundsRadius and uvDensity
+    void computeBounds(const void *vertexData, size_t vertexCount, bool packed, const unsigned int *indexData,
+                       size_t indexCount)
+    {
+        const char *bytes = (const char *)vertexData;
+        size_t stride = packed ? sizeof(PackedVertex) : sizeof(Vertex);
+        // Position comes first in both layouts
+        auto position = [&](size_t i) { return *(const glm::vec3 *)(bytes + i * stride); };
+        auto texCoords = [&](size_t i) {
+            if (!packed)
+                return ((const Vertex *)vertexData)[i].TexCoords;
+            uint32_t uv = ((const PackedVertex *)vertexData)[i].TexCoords;
+            return glm::vec2(uv & 0xFFFF, uv >> 16) / 65535.0f;
+        };
+        if (vertexCount == 0)
+            return;
+
+        glm::vec3 low = position(0), high = position(0);
+        for (size_t i = 1; i < vertexCount; i++)
+        {
+            low = glm::min(low, position(i));
+            high = glm::max(high, position(i));
+        }
+        boundsCenter = (low + high) * 0.5f;
+        for (size_t i = 0; i < vertexCount; i++)
+            boundsRadius = std::max(boundsRadius, glm::length(position(i) - boundsCenter));
+
+        // the square root of texture area over surface area
+        double area = 0.0, uvArea = 0.0;
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            unsigned int a = indexData[i], b = indexData[i + 1], c = indexData[i + 2];
+            area += glm::length(glm::cross(position(b) - position(a), position(c) - position(a)));
+            glm::vec2 u = texCoords(b) - texCoords(a), v = texCoords(c) - texCoords(a);
+            uvArea += std::abs(u.x * v.y - u.y * v.x);
+        }
+        uvDensity = area > 0.0 ? (float)std::sqrt(uvArea / area) : 0.0f;
     }
 };
 #endif
\ No newline at end of file
@@ -12,7 +12,14 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
-
+#include <rg/CookedAssets.h>
+#include <rg/JobSystem.h>
+#include <rg/MemoryTracker.h>
+#include <rg/Pak.h>
+#include <rg/Profiler.h>
+#include <rg/TextureStreamer.h>
+
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -21,6 +28,18 @@
 #include <vector>
 using namespace std;
 
+// pixels as decoded by stb_image, kept apart from the GL upload so that decoding can run on any thread
+struct TextureImage
+{
+    unsigned char *data = nullptr;
+    int width = 0;
+    int height = 0;
+    int components = 0;
+};
+
+TextureImage LoadTextureImage(const char *path, const string &directory);
+unsigned int UploadTexture(TextureImage &image);
+unsigned int UploadCookedTexture(const rg::CookedTexture &texture);
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
 
@@ -33,71 +52,79 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // whether the meshes keep their vertices and indices once they are uploaded, for CPU-side work such as picking.
+    // Without it only their counts and bounds stay in memory. Cooked meshes never have CPU copies.
+    bool keepCpuGeometry;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, bool keepGeometry = false)
+        : gammaCorrection(gamma), keepCpuGeometry(keepGeometry)
     {
+        PROFILE_CPU_SCOPE("Model " + path);
+        rg::MemoryOwnerScope owner(path);
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
+    // constructor for a scene that was already imported from path, skips the ASSIMP import
+    Model(const aiScene *scene, string const &path, bool gamma = false, bool keepGeometry = false)
+        : gammaCorrection(gamma), keepCpuGeometry(keepGeometry)
     {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        directory = path.substr(0, path.find_last_of('/'));
+        rg::MemoryOwnerScope owner(path);
+        processScene(scene);
     }
 
-    void SetShaderTextureNamePrefix(std::string prefix) {
-        for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
-        }
-    }
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
-    {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // check for errors
-        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
-        {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
-        }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
+    // the mesh groups point into meshes, so a model is moved, never copied; the moved-from one is left empty
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+    Model &operator=(Model &&) = delete;
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+    Model(Model &&other)
+        : textures_loaded(std::move(other.textures_loaded)), meshes(std::move(other.meshes)),
+          directory(std::move(other.directory)), gammaCorrection(other.gammaCorrection),
+          keepCpuGeometry(other.keepCpuGeometry)
+    {
+        other.meshes.clear();
+        other.meshGroups.clear();
+        groupMeshes();
+        rg::memoryTracker().cpuFreed(&other);
+        trackCpuGeometry();
     }
 
-    // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
-    {
-        // process each mesh located at the current node
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            // the node object only contains indices to index the actual objects in the scene.
-            // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
-        }
-        // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
-        {
-            processNode(node->mChildren[i], scene);
-        }
+    // post-processing applied to every imported file
+    static const unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
 
+    // material texture slots in the order the meshes bind them, with the sampler name prefix each one gets:
+    // diffuse: texture_diffuseN, specular: texture_specularN, normal: texture_normalN, height: texture_heightN
+    static const vector<pair<aiTextureType, string>> &textureSlots()
+    {
+        static const vector<pair<aiTextureType, string>> slots = {
+            {aiTextureType_DIFFUSE, "texture_diffuse"},
+            {aiTextureType_SPECULAR, "texture_specular"},
+            {aiTextureType_HEIGHT, "texture_normal"},
+            {aiTextureType_AMBIENT, "texture_height"}};
+        return slots;
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    // the MTL colours and shininess of a material
+    static rg::MaterialParams materialParams(const aiMaterial *material)
     {
-        // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        rg::MaterialParams params;
+        aiColor3D color;
+        if (material->Get(AI_MATKEY_COLOR_DIFFUSE, color) == aiReturn_SUCCESS)
+            params.Diffuse = glm::vec3(color.r, color.g, color.b);
+        if (material->Get(AI_MATKEY_COLOR_SPECULAR, color) == aiReturn_SUCCESS)
+            params.Specular = glm::vec3(color.r, color.g, color.b);
+        float shininess = 0.0f;
+        if (material->Get(AI_MATKEY_SHININESS, shininess) == aiReturn_SUCCESS && shininess > 0.0f)
+            params.Shininess = shininess;
+        return params;
+    }
 
+    // converts a mesh to our vertex and index format; touches no GL state, so it can run as a job.
+    static void processMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices)
+    {
+        vertices.reserve(mesh->mNumVertices);
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
@@ -137,7 +164,12 @@ private:
                 vertex.Bitangent = vector;
             }
             else
+            {
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+                // defined, so cooked models come out the same on every run
+                vertex.Tangent = glm::vec3(0.0f);
+                vertex.Bitangent = glm::vec3(0.0f);
+            }
 
             vertices.push_back(vertex);
 
@@ -151,35 +183,274 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
-        // process materials
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
-        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
-        // Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuseN
-        // specular: texture_specularN
-        // normal: texture_normalN
-        aiColor3D color(0.0f, 0.0f, 0.0f);
-        material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-
-
-        // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-        // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-        // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-
-
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+    }
+
+    // draws the model, and thus all its meshes
+    void Draw(Shader &shader)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader);
+    }
+
+    // records the draws of all meshes into a command list, see Mesh::Record
+    void Record(rg::CommandList &list) const
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Record(list);
+    }
+
+    // meshes with the same material, see MeshGroups()
+    struct MeshGroup
+    {
+        const rg::Material *material;
+        vector<const Mesh*> meshes;
+    };
+
+    // The meshes grouped by material and sorted by the shader permutation of the material, so a renderer walking
+    // the groups in order switches programs and materials as rarely as possible.
+    const vector<MeshGroup> &MeshGroups() const
+    {
+        return meshGroups;
+    }
+
+    // the distinct rg::Material::features() of the meshes, one shader permutation each
+    vector<unsigned int> Features() const
+    {
+        vector<unsigned int> features;
+        for (const MeshGroup &group : meshGroups)
+            if (features.empty() || features.back() != group.material->features())
+                features.push_back(group.material->features());
+        return features;
+    }
+
+    void SetShaderTextureNamePrefix(std::string prefix) {
+        for (Mesh& mesh: meshes) {
+            mesh.glslIdentifierPrefix = prefix;
+        }
+    }
+
+    // frees all GPU buffers and textures of the model
+    void Destroy()
+    {
+        for (Mesh& mesh: meshes)
+            mesh.Destroy();
+        for (Texture& texture: textures_loaded)
+        {
+            rg::textureStreamer().forget(texture.id);
+            glDeleteTextures(1, &texture.id);
+            rg::glState().textureDeleted(texture.id);
+            rg::memoryTracker().textureDeleted(texture.id);
+        }
+        rg::memoryTracker().cpuFreed(this);
+        meshes.clear();
+        meshGroups.clear();
+        textures_loaded.clear();
+    }
+private:
+    // point into meshes
+    vector<MeshGroup> meshGroups;
+
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    // A cooked copy in the asset package (rg::pak()) is used instead when there is one.
+    void loadModel(string const &path)
+    {
+        rg::CookedModel cooked(rg::pak().find(path));
+        if (cooked.valid() && cookedLayoutMatches(cooked.header()))
+        {
+            directory = path.substr(0, path.find_last_of('/'));
+            loadCooked(cooked);
+            return;
+        }
+        if (cooked.valid())
+            cout << "The package has " << path << " cooked for another vertex layout, loading the source" << endl;
+        // read file via ASSIMP
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, ImportFlags);
+        // check for errors
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
+        {
+            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
+            return;
+        }
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        processScene(scene);
+    }
+
+    // whether the vertices of a model blob have the layout this build draws
+    static bool cookedLayoutMatches(const rg::CookedModelHeader &header)
+    {
+        switch (header.VertexFormat)
+        {
+            case rg::CookedVertexFormat::Float: return header.VertexSize == sizeof(Vertex);
+            case rg::CookedVertexFormat::Packed: return header.VertexSize == sizeof(PackedVertex);
+        }
+        return false;
+    }
+
+    // builds all meshes of a model blob. Vertex and index data go to the GL buffers straight from the package,
+    // textures through pixel unpack buffers; nothing is decoded or converted.
+    void loadCooked(const rg::CookedModel &cooked)
+    {
+        PROFILE_CPU_SCOPE("Cooked model " + string(cooked.name()));
+        // textures by the pak name hash, each uploaded once
+        map<uint64_t, unsigned int> uploaded;
+        for (uint32_t i = 0; i < cooked.header().MeshCount; i++)
+        {
+            const rg::CookedMesh &mesh = cooked.mesh(i);
+            vector<Texture> textures;
+            for (uint32_t j = mesh.FirstTextureRef; j < mesh.FirstTextureRef + mesh.TextureRefCount; j++)
+            {
+                const rg::CookedTextureRef &ref = cooked.textureRef(j);
+                rg::PakBlob blob = rg::pak().find(ref.NameHash);
+                auto texture = uploaded.find(ref.NameHash);
+                if (texture == uploaded.end())
+                {
+                    rg::CookedTexture cookedTexture(blob);
+                    if (!cookedTexture.valid())
+                    {
+                        cout << "ERROR::PAK:: " << cooked.name() << " uses a texture the package does not have" << endl;
+                        continue;
+                    }
+                    unsigned int id;
+                    if (cookedTexture.uploadable())
+                        id = UploadCookedTexture(cookedTexture);
+                    else
+                    {
+                        // the blob is named after the source image
+                        TextureImage image = LoadTextureImage(blob.Name, ".");
+                        id = UploadTexture(image);
+                    }
+                    texture = uploaded.insert({ref.NameHash, id}).first;
+                    textures_loaded.push_back({texture->second, textureSlots()[(uint32_t) ref.Slot].second, blob.Name});
+                }
+                textures.push_back({texture->second, textureSlots()[(uint32_t) ref.Slot].second, blob.Name});
+            }
+            if (cooked.header().VertexFormat == rg::CookedVertexFormat::Packed)
+                meshes.push_back(Mesh((const PackedVertex*) cooked.vertices(mesh), mesh.VertexCount,
+                                      cooked.indices(mesh), mesh.IndexCount, textures));
+            else
+                meshes.push_back(Mesh((const Vertex*) cooked.vertices(mesh), mesh.VertexCount, cooked.indices(mesh),
+                                      mesh.IndexCount, textures));
+            meshes.back().material = rg::materials().get(materialDesc(mesh.Params, textures));
+        }
+        groupMeshes();
+    }
+
+    // builds all meshes of the scene. Vertex conversion and texture decoding are spread over the job system,
+    // the GL buffers and textures are created afterwards on the calling thread, which owns the context.
+    void processScene(const aiScene *scene)
+    {
+        vector<aiMesh*> sceneMeshes;
+        processNode(scene->mRootNode, scene, sceneMeshes);
+
+        // every texture file the materials use that is not loaded yet, with the type of its first use
+        vector<Texture> newTextures;
+        for (aiMesh *mesh : sceneMeshes)
+        {
+            aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
+            for (const auto &slot : textureSlots())
+            {
+                for (unsigned int i = 0; i < material->GetTextureCount(slot.first); i++)
+                {
+                    aiString str;
+                    material->GetTexture(slot.first, i, &str);
+                    auto samePath = [&str](const Texture &texture) { return texture.path == str.C_Str(); };
+                    if (find_if(textures_loaded.begin(), textures_loaded.end(), samePath) == textures_loaded.end() &&
+                        find_if(newTextures.begin(), newTextures.end(), samePath) == newTextures.end())
+                        newTextures.push_back({0, slot.second, str.C_Str()});
+                }
+            }
+        }
+
+        vector<TextureImage> images(newTextures.size());
+        vector<vector<Vertex>> vertices(sceneMeshes.size());
+        vector<vector<unsigned int>> indices(sceneMeshes.size());
+        rg::JobSystem &jobs = rg::jobs();
+        rg::JobCounter counter;
+        for (size_t i = 0; i < newTextures.size(); i++)
+            jobs.run("Decode texture", [&, i] { images[i] = LoadTextureImage(newTextures[i].path.c_str(), directory); }, &counter);
+        for (size_t i = 0; i < sceneMeshes.size(); i++)
+            jobs.run("Process mesh", [&, i] { processMesh(sceneMeshes[i], vertices[i], indices[i]); }, &counter);
+        jobs.wait(counter);
+
+        for (size_t i = 0; i < newTextures.size(); i++)
+        {
+            newTextures[i].id = UploadTexture(images[i]);
+            textures_loaded.push_back(newTextures[i]);
+        }
+        for (size_t i = 0; i < sceneMeshes.size(); i++)
+        {
+            aiMaterial *material = scene->mMaterials[sceneMeshes[i]->mMaterialIndex];
+            vector<Texture> textures;
+            for (const auto &slot : textureSlots())
+            {
+                vector<Texture> maps = loadMaterialTextures(material, slot.first, slot.second);
+                textures.insert(textures.end(), maps.begin(), maps.end());
+            }
+            meshes.push_back(Mesh(std::move(vertices[i]), std::move(indices[i]), textures));
+            meshes.back().material = rg::materials().get(materialDesc(materialParams(material), textures));
+            if (!keepCpuGeometry)
+                meshes.back().ReleaseCpuGeometry();
+        }
+        groupMeshes();
+        trackCpuGeometry();
+    }
+
+    // reports the vertices and indices the meshes keep to rg::memoryTracker()
+    void trackCpuGeometry()
+    {
+        size_t bytes = 0;
+        for (const Mesh &mesh : meshes)
+            bytes += mesh.vertices.capacity() * sizeof(Vertex) + mesh.indices.capacity() * sizeof(unsigned int);
+        if (bytes > 0)
+            rg::memoryTracker().cpuAllocated(this, bytes, rg::MemoryCategory::CpuGeometry);
+    }
+
+    // the rg::Material of a mesh: its first map of each kind and params
+    static rg::MaterialDesc materialDesc(const rg::MaterialParams &params, const vector<Texture> &textures)
+    {
+        rg::MaterialDesc desc;
+        desc.Params = params;
+        for (const Texture &texture : textures)
+        {
+            GLuint *map = texture.type == "texture_diffuse" ? &desc.DiffuseMap
+                        : texture.type == "texture_specular" ? &desc.SpecularMap
+                        : texture.type == "texture_normal" ? &desc.NormalMap : nullptr;
+            if (map && !*map)
+                *map = texture.id;
+        }
+        return desc;
+    }
+
+    // fills meshGroups, see MeshGroups()
+    void groupMeshes()
+    {
+        meshGroups.clear();
+        for (const Mesh &mesh : meshes)
+        {
+            auto sameMaterial = [&mesh](const MeshGroup &group) { return group.material == mesh.material; };
+            auto group = find_if(meshGroups.begin(), meshGroups.end(), sameMaterial);
+            if (group == meshGroups.end())
+                meshGroups.push_back({mesh.material, {&mesh}});
+            else
+                group->meshes.push_back(&mesh);
+        }
+        stable_sort(meshGroups.begin(), meshGroups.end(), [](const MeshGroup &a, const MeshGroup &b) {
+            return a.material->features() < b.material->features();
+        });
+    }
+
+    // collects the meshes of a node and, recursively, of its children (if any), in drawing order.
+    void processNode(aiNode *node, const aiScene *scene, vector<aiMesh*> &sceneMeshes)
+    {
+        // the node object only contains indices to index the actual objects in the scene.
+        // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+            sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+            processNode(node->mChildren[i], scene, sceneMeshes);
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -217,43 +488,87 @@ private:
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+TextureImage LoadTextureImage(const char *path, const string &directory)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
+    PROFILE_CPU_SCOPE("Texture " + filename);
+
+    TextureImage image;
+    image.data = stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0);
+    if (!image.data)
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    return image;
+}
 
+// creates the GL texture and frees the pixels
+unsigned int UploadTexture(TextureImage &image)
+{
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
+    if (image.data)
     {
         GLenum format;
-        if (nrComponents == 1)
+        if (image.components == 1)
             format = GL_RED;
-        else if (nrComponents == 3)
+        else if (image.components == 3)
             format = GL_RGB;
-        else if (nrComponents == 4)
+        else if (image.components == 4)
             format = GL_RGBA;
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        rg::glState().bindTexture(0, GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        rg::memoryTracker().textureLevelAllocated(textureID, GL_TEXTURE_2D, 0, format, image.width, image.height, 0,
+                                                  rg::MemoryCategory::Texture);
+        rg::memoryTracker().textureMipmapsGenerated(textureID);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        stbi_image_free(data);
+        stbi_image_free(image.data);
+        image.data = nullptr;
     }
+
+    return textureID;
+}
+
+// creates the GL texture from a cooked one; mipmaps are generated when the package has only the base level.
+// A texture with a mip chain gets only its smallest levels here, rg::textureStreamer() brings in the others as
+// they are seen from closer.
+unsigned int UploadCookedTexture(const rg::CookedTexture &texture)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    rg::glState().bindTexture(0, GL_TEXTURE_2D, textureID);
+    if (texture.header().Levels > 1 && rg::textureStreamer().Enabled)
+        rg::textureStreamer().add(textureID, texture);
     else
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        uint32_t levels = texture.upload(GL_TEXTURE_2D);
+        texture.track(textureID, GL_TEXTURE_2D, 0, levels);
+        if (levels == 1 && !texture.compressed())
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            rg::memoryTracker().textureMipmapsGenerated(textureID);
+        }
+        else
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
     }
 
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     return textureID;
 }
+
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+{
+    TextureImage image = LoadTextureImage(path, directory);
+    return UploadTexture(image);
+}
 #endif
@@ -4,24 +4,190 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <rg/GLExtensions.h>
+#include <rg/GLState.h>
+#include <rg/Profiler.h>
+
+// KHR_parallel_shader_compile is not part of the generated 3.3 loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly; defines ("#define FOG\n"...)
+    // go right after the #version line of every stage
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           std::string defines = "")
+        : m_VertexPath(vertexPath), m_FragmentPath(fragmentPath), m_GeometryPath(geometryPath ? geometryPath : "")
+        , m_Defines(std::move(defines))
+    {
+        PROFILE_CPU_SCOPE(std::string("Shader ") + fragmentPath);
+        beginBuild();
+        ID = finishBuild();
+    }
+    // source files including everything they #include, for watching them
+    // while the app runs
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    std::vector<std::string> sources() const
+    {
+        std::vector<std::string> paths = {m_VertexPath, m_FragmentPath};
+        if (!m_GeometryPath.empty())
+            paths.push_back(m_GeometryPath);
+        paths.insert(paths.end(), m_Includes.begin(), m_Includes.end());
+        return paths;
+    }
+    // Rebuilds the program from its sources next to the current one, which
+    // stays in use until finishReload(). With KHR_parallel_shader_compile the
+    // driver compiles on its own threads and nothing here waits for it.
+    // ------------------------------------------------------------------------
+    void beginReload()
+    {
+        cancelReload();
+        beginBuild();
+    }
+    bool reloading() const
     {
-        std::string vertexPathString(vertexPath);
-        std::string fragmentPathString(fragmentPath);
+        return m_Pending != 0;
+    }
+    // true once finishReload() will not block
+    bool reloadReady() const
+    {
+        if (!m_Pending || !parallelCompile())
+            return true;
+        GLint done = GL_FALSE;
+        glGetProgramiv(m_Pending, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+    // Swaps the rebuilt program in and deletes the old one. On errors the old
+    // program is kept and false is returned. Uniform values and block bindings
+    // start over at their defaults in the new program.
+    bool finishReload()
+    {
+        if (!m_Pending)
+            return false;
+        unsigned int program = finishBuild();
+        if (!program)
+            return false;
+        glDeleteProgram(ID);
+        rg::glState().programDeleted(ID);
+        ID = program;
+        return true;
+    }
+    void cancelReload()
+    {
+        if (!m_Pending)
+            return;
+        for (unsigned int shader : m_PendingShaders)
+            glDeleteShader(shader);
+        m_PendingShaders.clear();
+        glDeleteProgram(m_Pending);
+        m_Pending = 0;
+    }
+    // activate the shader
+    // ------------------------------------------------------------------------
+    void use() 
+    { 
+        rg::glState().useProgram(ID);
+    }
+    // utility uniform functions
+    // ------------------------------------------------------------------------
+    void setBool(const std::string &name, bool value) const
+    {         
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    }
+    // ------------------------------------------------------------------------
+    void setInt(const std::string &name, int value) const
+    { 
+        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string &name, float value) const
+    { 
+        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec2(const std::string &name, const glm::vec2 &value) const
+    { 
+        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    }
+    void setVec2(const std::string &name, float x, float y) const
+    { 
+        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(const std::string &name, const glm::vec3 &value) const
+    { 
+        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    }
+    void setVec3(const std::string &name, float x, float y, float z) const
+    { 
+        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    }
+    // ------------------------------------------------------------------------
+    void setVec4(const std::string &name, const glm::vec4 &value) const
+    { 
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    { 
+        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    }
 
-        vertexPath = vertexPathString.c_str();
-        fragmentPath= fragmentPathString.c_str();
+private:
+    std::string m_VertexPath;
+    std::string m_FragmentPath;
+    std::string m_GeometryPath;
+    std::string m_Defines;
+    // files #included by the last build; #line source string N is m_Includes[N - 1]
+    std::vector<std::string> m_Includes;
+    // program being built and its shader objects, deleted once it is linked
+    unsigned int m_Pending = 0;
+    std::vector<unsigned int> m_PendingShaders;
+
+    // KHR_parallel_shader_compile and its ARB twin are not in the generated
+    // 3.3 loader; querying the completion status is all that is needed, the
+    // driver picks the number of compiler threads by default
+    static bool parallelCompile()
+    {
+        static const bool supported =
+            rg::hasExtension("GL_KHR_parallel_shader_compile") || rg::hasExtension("GL_ARB_parallel_shader_compile");
+        return supported;
+    }
+    // queues compiling and linking the sources into m_Pending without asking
+    // for the results, so the driver does not have to wait for them
+    // ------------------------------------------------------------------------
+    void beginBuild()
+    {
+        const char* vertexPath = m_VertexPath.c_str();
+        const char* fragmentPath = m_FragmentPath.c_str();
+        const char* geometryPath = m_GeometryPath.empty() ? nullptr : m_GeometryPath.c_str();
+        m_Includes.clear();
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -46,18 +212,16 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
+            vertexCode = preprocess(vShaderStream.str(), m_VertexPath);
+            fragmentCode = preprocess(fShaderStream.str(), m_FragmentPath);
             // if geometry shader path is present, also load a geometry shader
             if(geometryPath != nullptr)
             {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
                 gShaderFile.open(geometryPath);
                 std::stringstream gShaderStream;
                 gShaderStream << gShaderFile.rdbuf();
                 gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                geometryCode = preprocess(gShaderStream.str(), m_GeometryPath);
             }
         }
         catch (std::ifstream::failure& e)
@@ -72,106 +236,120 @@ public:
         vertex = glCreateShader(GL_VERTEX_SHADER);
         glShaderSource(vertex, 1, &vShaderCode, NULL);
         glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
         // fragment Shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
         glShaderSource(fragment, 1, &fShaderCode, NULL);
         glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
+        m_PendingShaders = {vertex, fragment};
         // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
         if(geometryPath != nullptr)
         {
             const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            unsigned int geometry = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometry, 1, &gShaderCode, NULL);
             glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            m_PendingShaders.push_back(geometry);
         }
         // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
-    }
-    // activate the shader
-    // ------------------------------------------------------------------------
-    void use() 
-    { 
-        glUseProgram(ID); 
-    }
-    // utility uniform functions
-    // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
-    }
-    // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
-    }
-    // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
-    }
-    // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
-    { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
-    }
-    void setVec2(const std::string &name, float x, float y) const
-    { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        m_Pending = glCreateProgram();
+        for (unsigned int shader : m_PendingShaders)
+            glAttachShader(m_Pending, shader);
+        glLinkProgram(m_Pending);
     }
+    // Adds the defines after #version and replaces #include "file" lines,
+    // relative to the including file, with the file. A file is included once
+    // per stage. #line directives keep compile errors pointing at the right
+    // line; source string 0 is the stage's own file.
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
-    { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
-    }
-    void setVec3(const std::string &name, float x, float y, float z) const
-    { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
-    }
-    // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
-    { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
-    }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
-    { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
-    }
-    // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    std::string preprocess(const std::string& source, const std::string& path)
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        std::vector<std::string> included;
+        return preprocess(source, path, 0, included);
     }
-    // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    std::string preprocess(const std::string& source, const std::string& path, int sourceNumber,
+                           std::vector<std::string>& included)
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        std::istringstream in(source);
+        std::string out;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            ++lineNumber;
+            std::string next = "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line[start] != '#')
+            {
+                out += line + "\n";
+            }
+            else if (sourceNumber == 0 && line.compare(start, 8, "#version") == 0)
+            {
+                out += line + "\n" + m_Defines + (m_Defines.empty() ? "" : next);
+            }
+            else if (line.compare(start, 8, "#include") == 0)
+            {
+                size_t open = line.find('"', start);
+                size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                if (close == std::string::npos)
+                {
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE " << path << ":" << lineNumber << std::endl;
+                    out += "\n";
+                    continue;
+                }
+                std::string file = directory + line.substr(open + 1, close - open - 1);
+                if (std::find(included.begin(), included.end(), file) != included.end())
+                {
+                    out += "\n";
+                    continue;
+                }
+                included.push_back(file);
+                auto known = std::find(m_Includes.begin(), m_Includes.end(), file);
+                int fileNumber = (int) (known - m_Includes.begin()) + 1;
+                if (known == m_Includes.end())
+                    m_Includes.push_back(file);
+                std::string contents = readFileContents(file);
+                if (contents.empty())
+                    std::cout << "ERROR::SHADER::INCLUDE_NOT_SUCCESFULLY_READ " << file << std::endl;
+                out += "#line 1 " + std::to_string(fileNumber) + "\n"
+                    + preprocess(contents, file, fileNumber, included) + next;
+            }
+            else
+            {
+                out += line + "\n";
+            }
+        }
+        return out;
     }
+    // reports errors of the queued build, waiting for it if need be; returns
+    // the program, or 0 when it did not link
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    unsigned int finishBuild()
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        static const char* types[] = {"VERTEX", "FRAGMENT", "GEOMETRY"};
+        bool compiled = true;
+        for (size_t i = 0; i < m_PendingShaders.size(); i++)
+            compiled = checkCompileErrors(m_PendingShaders[i], types[i]) && compiled;
+        if (!compiled)
+            for (size_t i = 0; i < m_Includes.size(); i++)
+                std::cout << "source string " << i + 1 << ": " << m_Includes[i] << std::endl;
+        bool linked = checkCompileErrors(m_Pending, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer necessery
+        for (unsigned int shader : m_PendingShaders)
+            glDeleteShader(shader);
+        m_PendingShaders.clear();
+        unsigned int program = m_Pending;
+        m_Pending = 0;
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
     }
-
-private:
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -193,6 +371,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success;
     }
 };
 #endif
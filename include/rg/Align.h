@@ -0,0 +1,18 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_ALIGN_H
+#define PROJECT_BASE_ALIGN_H
+
+namespace rg {
+
+// value rounded up to a multiple of alignment, which need not be a power of two
+template <typename T>
+inline T alignUp(T value, T alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+};
+
+#endif //PROJECT_BASE_ALIGN_H
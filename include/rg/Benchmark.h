@@ -0,0 +1,265 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_BENCHMARK_H
+#define PROJECT_BASE_BENCHMARK_H
+
+#include <glm/glm.hpp>
+#include <rg/DrawStats.h>
+#include <rg/Json.h>
+#include <rg/Profiler.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Camera pose at a point of the flythrough, angles in degrees as in Camera.
+struct CameraKeyframe {
+    float time;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+// Scripted, fixed time step run of the render loop that reports frame time
+// statistics. The config is a JSON file:
+//
+//   {
+//     "frames": 600, "warmupFrames": 60, "width": 1920, "height": 1080,
+//     "timeStep": 0.0166, "output": "benchmark.json",
+//     "keyframes": [
+//       {"time": 0, "position": [0, 2, 30], "yaw": -90, "pitch": 0},
+//       {"time": 5, "position": [0, 5, -60], "yaw": -90, "pitch": -10}
+//     ]
+//   }
+//
+// Render settings (anti-aliasing etc.) are read by the caller from settings().
+// Frame n shows the scene at time n * timeStep no matter how long it took to
+// render, so every run draws exactly the same images.
+class Benchmark {
+public:
+    int Frames = 600;
+    int WarmupFrames = 60;
+    int Width = 1920;
+    int Height = 1080;
+    float TimeStep = 1.0f / 60.0f;
+    std::string OutputPath = "benchmark.json";
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Failed to open benchmark config " << path << std::endl;
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        std::string error;
+        if (!JsonValue::parse(text.str(), m_Settings, error)) {
+            std::cerr << "Failed to parse benchmark config " << path << ": " << error << std::endl;
+            return false;
+        }
+        m_ConfigPath = path;
+        Frames = std::max(1, (int) m_Settings["frames"].asNumber(Frames));
+        WarmupFrames = std::max(0, (int) m_Settings["warmupFrames"].asNumber(WarmupFrames));
+        Width = (int) m_Settings["width"].asNumber(Width);
+        Height = (int) m_Settings["height"].asNumber(Height);
+        TimeStep = (float) m_Settings["timeStep"].asNumber(TimeStep);
+        OutputPath = m_Settings["output"].asString(OutputPath);
+
+        const JsonValue& keyframes = m_Settings["keyframes"];
+        m_Keyframes.clear();
+        for (size_t i = 0; i < keyframes.size(); i++) {
+            const JsonValue& key = keyframes[i];
+            const JsonValue& position = key["position"];
+            CameraKeyframe keyframe;
+            keyframe.time = (float) key["time"].asNumber(i);
+            keyframe.position = glm::vec3(position[0].asNumber(), position[1].asNumber(), position[2].asNumber());
+            keyframe.yaw = (float) key["yaw"].asNumber(-90.0);
+            keyframe.pitch = (float) key["pitch"].asNumber();
+            m_Keyframes.push_back(keyframe);
+        }
+        if (m_Keyframes.empty()) {
+            std::cerr << "Benchmark config " << path << " has no keyframes" << std::endl;
+            return false;
+        }
+        std::sort(m_Keyframes.begin(), m_Keyframes.end(),
+                  [](const CameraKeyframe& a, const CameraKeyframe& b) { return a.time < b.time; });
+        return true;
+    }
+
+    const JsonValue& settings() const {
+        return m_Settings;
+    }
+
+    float sceneTime(int frame) const {
+        return frame * TimeStep;
+    }
+
+    // Catmull-Rom spline through the keyframes, holding the end poses outside them.
+    CameraKeyframe cameraAt(float time) const {
+        if (time <= m_Keyframes.front().time) {
+            return m_Keyframes.front();
+        }
+        if (time >= m_Keyframes.back().time) {
+            return m_Keyframes.back();
+        }
+        size_t i = 0;
+        while (m_Keyframes[i + 1].time <= time) {
+            ++i;
+        }
+        const CameraKeyframe& p0 = m_Keyframes[i == 0 ? 0 : i - 1];
+        const CameraKeyframe& p1 = m_Keyframes[i];
+        const CameraKeyframe& p2 = m_Keyframes[i + 1];
+        const CameraKeyframe& p3 = m_Keyframes[std::min(i + 2, m_Keyframes.size() - 1)];
+        float t = (time - p1.time) / (p2.time - p1.time);
+
+        CameraKeyframe result;
+        result.time = time;
+        result.position = catmullRom(p0.position, p1.position, p2.position, p3.position, t);
+        glm::vec3 angles = catmullRom(glm::vec3(p0.yaw, p0.pitch, 0.0f), glm::vec3(p1.yaw, p1.pitch, 0.0f),
+                                      glm::vec3(p2.yaw, p2.pitch, 0.0f), glm::vec3(p3.yaw, p3.pitch, 0.0f), t);
+        result.yaw = angles.x;
+        result.pitch = glm::clamp(angles.y, -89.0f, 89.0f);
+        return result;
+    }
+
+    bool measured(int frame) const {
+        return frame >= WarmupFrames && frame < WarmupFrames + Frames;
+    }
+
+    // Call once per frame after submitting it, with the wall time since the
+    // previous frame and this frame's draw counters.
+    void recordFrame(int frame, double frameMs, const DrawStats& draws) {
+        if (!measured(frame)) {
+            return;
+        }
+        m_FrameMs.push_back(frameMs);
+        m_DrawCalls.push_back((double) draws.drawCalls);
+        m_Triangles.push_back((double) draws.triangles);
+    }
+
+    // Picks up the newest completed frame of the profiler, if it is a measured one.
+    // Every frame only completes once, so this can be called every frame.
+    void recordProfile(const Profiler& profiler) {
+        if (!profiler.hasResult()) {
+            return;
+        }
+        int frame = (int) profiler.completedFrame();
+        if (!measured(frame) || frame == m_LastProfiledFrame) {
+            return;
+        }
+        m_LastProfiledFrame = frame;
+        m_CpuFrameMs.push_back(profiler.lastCpuFrameMs());
+        m_GpuFrameMs.push_back(profiler.lastGpuFrameMs());
+        for (const ProfileRecord& record : profiler.lastFrame()) {
+            auto pass = std::find_if(m_Passes.begin(), m_Passes.end(),
+                                     [&](const PassTotals& p) { return p.name == record.name; });
+            if (pass == m_Passes.end()) {
+                PassTotals totals;
+                totals.name = record.name;
+                totals.depth = record.depth;
+                m_Passes.push_back(totals);
+                pass = m_Passes.end() - 1;
+            }
+            pass->cpuMs += record.cpuMs;
+            pass->gpuMs += record.gpuMs;
+            ++pass->count;
+        }
+    }
+
+    // True once every measured frame has been rendered and its GPU results read.
+    bool done() const {
+        return m_LastProfiledFrame >= WarmupFrames + Frames - 1;
+    }
+
+    bool writeReport() const {
+        std::ofstream out(OutputPath);
+        if (!out) {
+            std::cerr << "Failed to write benchmark report " << OutputPath << std::endl;
+            return false;
+        }
+        out << "{\n";
+        out << "  \"config\": " << jsonString(m_ConfigPath) << ",\n";
+        out << "  \"frames\": " << Frames << ",\n";
+        out << "  \"width\": " << Width << ",\n";
+        out << "  \"height\": " << Height << ",\n";
+        out << "  \"frameMs\": " << summary(m_FrameMs) << ",\n";
+        out << "  \"cpuFrameMs\": " << summary(m_CpuFrameMs) << ",\n";
+        out << "  \"gpuFrameMs\": " << summary(m_GpuFrameMs) << ",\n";
+        out << "  \"drawCalls\": " << summary(m_DrawCalls) << ",\n";
+        out << "  \"triangles\": " << summary(m_Triangles) << ",\n";
+        out << "  \"passes\": [";
+        for (size_t i = 0; i < m_Passes.size(); i++) {
+            const PassTotals& pass = m_Passes[i];
+            // average over the frames the pass ran in
+            out << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << jsonString(pass.name)
+                << ", \"depth\": " << pass.depth << ", \"frames\": " << pass.count
+                << ", \"cpuMs\": " << pass.cpuMs / pass.count << ", \"gpuMs\": " << pass.gpuMs / pass.count << "}";
+        }
+        out << "\n  ]\n}\n";
+
+        std::cout << "Benchmark: " << Frames << " frames at " << Width << "x" << Height << "\n"
+                  << "  frame ms " << summary(m_FrameMs) << "\n"
+                  << "  GPU ms   " << summary(m_GpuFrameMs) << "\n"
+                  << "  written to " << OutputPath << std::endl;
+        return true;
+    }
+
+private:
+    struct PassTotals {
+        std::string name;
+        int depth = 0;
+        int count = 0;
+        double cpuMs = 0.0;
+        double gpuMs = 0.0;
+    };
+
+    JsonValue m_Settings;
+    std::string m_ConfigPath;
+    std::vector<CameraKeyframe> m_Keyframes;
+    std::vector<double> m_FrameMs;
+    std::vector<double> m_CpuFrameMs;
+    std::vector<double> m_GpuFrameMs;
+    std::vector<double> m_DrawCalls;
+    std::vector<double> m_Triangles;
+    std::vector<PassTotals> m_Passes;
+    int m_LastProfiledFrame = -1;
+
+    static glm::vec3 catmullRom(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t) {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                       (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+
+    // min/avg/max and nearest-rank percentiles as a JSON object
+    static std::string summary(std::vector<double> samples) {
+        if (samples.empty()) {
+            return "null";
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double sample : samples) {
+            sum += sample;
+        }
+        auto percentile = [&](double p) {
+            size_t rank = (size_t) std::ceil(p / 100.0 * samples.size());
+            return samples[std::min(std::max(rank, (size_t) 1), samples.size()) - 1];
+        };
+        std::ostringstream out;
+        out << "{\"min\": " << samples.front() << ", \"avg\": " << sum / samples.size()
+            << ", \"p50\": " << percentile(50) << ", \"p95\": " << percentile(95)
+            << ", \"p99\": " << percentile(99) << ", \"max\": " << samples.back() << "}";
+        return out.str();
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_BENCHMARK_H
@@ -0,0 +1,359 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_COMMANDLIST_H
+#define PROJECT_BASE_COMMANDLIST_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <rg/DrawStats.h>
+#include <rg/GLState.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+// Uniform locations of a linked program, queried once on the GL thread. It is
+// only read afterwards, so command lists can look locations up on any thread.
+class ProgramInfo {
+public:
+    ProgramInfo() = default;
+
+    explicit ProgramInfo(GLuint program) : m_Program(program) {
+        GLint count = 0;
+        GLint maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> name(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, i, (GLsizei) name.size(), &length, &size, &type, name.data());
+            std::string uniform(name.data(), length);
+            GLint location = glGetUniformLocation(program, uniform.c_str());
+            m_Locations[uniform] = location;
+            // arrays are reported as "name[0]" but also answer to "name"
+            if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) {
+                m_Locations[uniform.substr(0, uniform.size() - 3)] = location;
+            }
+        }
+    }
+
+    GLuint id() const {
+        return m_Program;
+    }
+
+    // -1, which GL ignores, for names that are not active in the program
+    GLint location(const std::string& name) const {
+        auto it = m_Locations.find(name);
+        return it != m_Locations.end() ? it->second : -1;
+    }
+
+private:
+    GLuint m_Program = 0;
+    std::unordered_map<std::string, GLint> m_Locations;
+};
+
+enum class Command : uint8_t {
+    UseProgram,
+    Uniform1i,
+    Uniform1f,
+    Uniform3f,
+    UniformMatrix4f,
+    BindTexture,
+    BindUniformBuffer,
+    BindVertexArray,
+    DrawElements,
+    DrawArrays,
+    Enable,
+    Disable,
+    StencilFunc,
+    StencilMask
+};
+
+// A render pass as a compact list of GL commands, recorded without touching
+// the context so that passes can be recorded on worker threads in parallel and
+// replayed on the GL thread afterwards. Commands are packed into one byte
+// buffer that is bump-allocated and reused frame to frame: reset() keeps the
+// memory, so a pass stops allocating once it has seen its largest frame.
+//
+// The setters mirror Shader and resolve names against the program of the last
+// use() call:
+//
+//   list.reset();
+//   list.use(cobraProgram);
+//   list.setMat4("model", model);
+//   cobraModel.Record(list);
+//   ...
+//   replayer.execute(list);      // on the GL thread
+class CommandList {
+public:
+    void reset() {
+        m_Data.clear();
+        m_Program = nullptr;
+        m_Commands = 0;
+    }
+
+    void use(const ProgramInfo& program) {
+        m_Program = &program;
+        GLuint id = program.id();
+        push(Command::UseProgram, &id, sizeof(id));
+    }
+
+    void setInt(const std::string& name, int value) {
+        GLint location = uniformLocation(name);
+        if (location >= 0) {
+            pushUniform(Command::Uniform1i, location, &value, sizeof(value));
+        }
+    }
+
+    void setFloat(const std::string& name, float value) {
+        GLint location = uniformLocation(name);
+        if (location >= 0) {
+            pushUniform(Command::Uniform1f, location, &value, sizeof(value));
+        }
+    }
+
+    void setVec3(const std::string& name, const glm::vec3& value) {
+        GLint location = uniformLocation(name);
+        if (location >= 0) {
+            pushUniform(Command::Uniform3f, location, glm::value_ptr(value), sizeof(value));
+        }
+    }
+
+    void setMat4(const std::string& name, const glm::mat4& value) {
+        GLint location = uniformLocation(name);
+        if (location >= 0) {
+            pushUniform(Command::UniformMatrix4f, location, glm::value_ptr(value), sizeof(value));
+        }
+    }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        GLuint payload[3] = {unit, target, texture};
+        push(Command::BindTexture, payload, sizeof(payload));
+    }
+
+    void bindUniformBuffer(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        GLuint payload[4] = {index, buffer, (GLuint) offset, (GLuint) size};
+        push(Command::BindUniformBuffer, payload, sizeof(payload));
+    }
+
+    void bindVertexArray(GLuint vao) {
+        push(Command::BindVertexArray, &vao, sizeof(vao));
+    }
+
+    void drawElements(GLenum mode, GLsizei count, GLenum type, GLuint offset = 0) {
+        GLuint payload[4] = {mode, (GLuint) count, type, offset};
+        push(Command::DrawElements, payload, sizeof(payload));
+    }
+
+    void drawArrays(GLenum mode, GLint first, GLsizei count) {
+        GLuint payload[3] = {mode, (GLuint) first, (GLuint) count};
+        push(Command::DrawArrays, payload, sizeof(payload));
+    }
+
+    void enable(GLenum cap) {
+        push(Command::Enable, &cap, sizeof(cap));
+    }
+
+    void disable(GLenum cap) {
+        push(Command::Disable, &cap, sizeof(cap));
+    }
+
+    void stencilFunc(GLenum func, GLint ref, GLuint mask) {
+        GLuint payload[3] = {func, (GLuint) ref, mask};
+        push(Command::StencilFunc, payload, sizeof(payload));
+    }
+
+    void stencilMask(GLuint mask) {
+        push(Command::StencilMask, &mask, sizeof(mask));
+    }
+
+    bool empty() const { return m_Commands == 0; }
+    size_t commands() const { return m_Commands; }
+    size_t bytes() const { return m_Data.size(); }
+
+private:
+    friend class CommandReplayer;
+
+    // every command starts with this, payload sizes are multiples of 4
+    struct Header {
+        Command type;
+        uint8_t unused;
+        uint16_t payloadSize;
+    };
+
+    std::vector<uint8_t> m_Data;
+    const ProgramInfo* m_Program = nullptr;
+    size_t m_Commands = 0;
+
+    GLint uniformLocation(const std::string& name) const {
+        return m_Program ? m_Program->location(name) : -1;
+    }
+
+    void push(Command type, const void* payload, size_t size) {
+        Header header = {type, 0, (uint16_t) size};
+        size_t offset = m_Data.size();
+        m_Data.resize(offset + sizeof(header) + size);
+        std::memcpy(&m_Data[offset], &header, sizeof(header));
+        std::memcpy(&m_Data[offset + sizeof(header)], payload, size);
+        ++m_Commands;
+    }
+
+    void pushUniform(Command type, GLint location, const void* values, size_t size) {
+        uint8_t payload[sizeof(GLint) + sizeof(glm::mat4)];
+        std::memcpy(payload, &location, sizeof(location));
+        std::memcpy(payload + sizeof(location), values, size);
+        push(type, payload, sizeof(location) + size);
+    }
+};
+
+// Replays command lists on the GL thread. Program, VAO, texture, uniform
+// buffer, capability and stencil changes go through GLState, which drops the ones that would not
+// change anything; uniform uploads of a value the program already holds are
+// dropped here. Uniform values are remembered until the next begin(), as code
+// outside the lists may set them in between frames.
+class CommandReplayer {
+public:
+    void begin() {
+        m_Uniforms.clear();
+        m_Executed = 0;
+        m_Skipped = 0;
+    }
+
+    void execute(const CommandList& list) {
+        const uint8_t* data = list.m_Data.data();
+        const uint8_t* end = data + list.m_Data.size();
+        while (data < end) {
+            CommandList::Header header;
+            std::memcpy(&header, data, sizeof(header));
+            data += sizeof(header);
+            if (run(header, data)) {
+                ++m_Executed;
+            } else {
+                ++m_Skipped;
+            }
+            data += header.payloadSize;
+        }
+    }
+
+    // uniform uploads issued to GL and uniform uploads dropped since begin();
+    // state changes are counted by GLState
+    unsigned long long executed() const { return m_Executed; }
+    unsigned long long skipped() const { return m_Skipped; }
+
+private:
+    struct UniformValue {
+        size_t size = 0;
+        uint8_t data[sizeof(glm::mat4)];
+    };
+
+    GLuint m_Program = 0;
+    // last value per (program, location), uniforms outlive program switches
+    std::unordered_map<uint64_t, UniformValue> m_Uniforms;
+    unsigned long long m_Executed = 0;
+    unsigned long long m_Skipped = 0;
+
+    static GLuint word(const uint8_t* payload, int index) {
+        GLuint value;
+        std::memcpy(&value, payload + index * sizeof(GLuint), sizeof(value));
+        return value;
+    }
+
+    // false when a uniform upload was dropped as redundant
+    bool run(const CommandList::Header& header, const uint8_t* payload) {
+        GLState& state = glState();
+        switch (header.type) {
+            case Command::UseProgram:
+                m_Program = word(payload, 0);
+                state.useProgram(m_Program);
+                return true;
+            case Command::Uniform1i:
+            case Command::Uniform1f:
+            case Command::Uniform3f:
+            case Command::UniformMatrix4f:
+                return uniform(header, payload);
+            case Command::BindTexture:
+                state.bindTexture(word(payload, 0), word(payload, 1), word(payload, 2));
+                return true;
+            case Command::BindUniformBuffer:
+                state.bindUniformBuffer(word(payload, 0), word(payload, 1), word(payload, 2), word(payload, 3));
+                return true;
+            case Command::BindVertexArray:
+                state.bindVertexArray(word(payload, 0));
+                return true;
+            case Command::DrawElements: {
+                GLenum mode = word(payload, 0);
+                GLsizei count = (GLsizei) word(payload, 1);
+                glDrawElements(mode, count, word(payload, 2), (void*) (uintptr_t) word(payload, 3));
+                rg::countDraw(mode, count);
+                return true;
+            }
+            case Command::DrawArrays: {
+                GLenum mode = word(payload, 0);
+                GLsizei count = (GLsizei) word(payload, 2);
+                glDrawArrays(mode, (GLint) word(payload, 1), count);
+                rg::countDraw(mode, count);
+                return true;
+            }
+            case Command::Enable:
+                state.enable(word(payload, 0));
+                return true;
+            case Command::Disable:
+                state.disable(word(payload, 0));
+                return true;
+            case Command::StencilFunc:
+                state.stencilFunc(word(payload, 0), (GLint) word(payload, 1), word(payload, 2));
+                return true;
+            case Command::StencilMask:
+                state.stencilMask(word(payload, 0));
+                return true;
+        }
+        return false;
+    }
+
+    bool uniform(const CommandList::Header& header, const uint8_t* payload) {
+        GLint location = (GLint) word(payload, 0);
+        const uint8_t* values = payload + sizeof(GLint);
+        size_t size = header.payloadSize - sizeof(GLint);
+        UniformValue& cached = m_Uniforms[(uint64_t) m_Program << 32 | (uint32_t) location];
+        if (cached.size == size && std::memcmp(cached.data, values, size) == 0) {
+            return false;
+        }
+        cached.size = size;
+        std::memcpy(cached.data, values, size);
+
+        float floats[16];
+        std::memcpy(floats, values, size);
+        switch (header.type) {
+            case Command::Uniform1i: {
+                GLint value;
+                std::memcpy(&value, values, sizeof(value));
+                glUniform1i(location, value);
+                break;
+            }
+            case Command::Uniform1f:
+                glUniform1f(location, floats[0]);
+                break;
+            case Command::Uniform3f:
+                glUniform3fv(location, 1, floats);
+                break;
+            default:
+                glUniformMatrix4fv(location, 1, GL_FALSE, floats);
+                break;
+        }
+        return true;
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_COMMANDLIST_H
@@ -0,0 +1,322 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_COOKEDASSETS_H
+#define PROJECT_BASE_COOKEDASSETS_H
+
+#include <glad/glad.h>
+#include <rg/Material.h>
+#include <rg/MemoryTracker.h>
+#include <rg/Pak.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// EXT_texture_compression_s3tc is not part of the generated 3.3 loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace rg {
+
+// Layouts of the blobs in a PakFile. Offsets are from the start of the blob;
+// every array starts 16 byte aligned.
+
+// Model: CookedModelHeader, CookedMesh[MeshCount],
+// CookedTextureRef[TextureRefCount], then vertex and index arrays.
+// how the vertices of a model are stored
+enum class CookedVertexFormat : uint32_t {
+    // Vertex
+    Float = 0,
+    // PackedVertex, for models whose texture coordinates are all in [0, 1]
+    Packed = 1,
+};
+
+struct CookedModelHeader {
+    uint32_t MeshCount;
+    uint32_t TextureRefCount;
+    CookedVertexFormat VertexFormat;
+    // bytes per vertex, a model cooked for another layout of the format is
+    // rejected
+    uint32_t VertexSize;
+};
+
+// which sampler of the mesh a texture is for, in the order of
+// Model::textureSlots()
+enum class CookedTextureSlot : uint32_t {
+    Diffuse = 0,
+    Specular = 1,
+    Normal = 2,
+    Height = 3,
+};
+
+struct CookedMesh {
+    uint64_t VertexOffset;
+    uint64_t IndexOffset;
+    uint32_t VertexCount;
+    // 32 bit indices
+    uint32_t IndexCount;
+    // range of the model's texture refs the mesh uses
+    uint32_t FirstTextureRef;
+    uint32_t TextureRefCount;
+    MaterialParams Params;
+};
+
+struct CookedTextureRef {
+    // pak name of the Texture blob
+    uint64_t NameHash;
+    CookedTextureSlot Slot;
+    uint32_t Padding;
+};
+
+// Texture: CookedTextureHeader, CookedTextureLevel[Levels], then the pixels
+// of every level, largest first.
+struct CookedTextureHeader {
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Levels;
+    // GL enums as glTexImage2D takes them; Format 0 marks a compressed
+    // internal format, uploaded with glCompressedTexImage2D
+    uint32_t InternalFormat;
+    uint32_t Format;
+    uint32_t Type;
+    uint32_t Padding[2];
+};
+
+struct CookedTextureLevel {
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+static_assert(sizeof(CookedModelHeader) == 16 && sizeof(CookedMesh) == 64 && sizeof(CookedTextureRef) == 16,
+              "cooked model structures are written as they are");
+static_assert(sizeof(CookedTextureHeader) == 32 && sizeof(CookedTextureLevel) == 24,
+              "cooked texture structures are written as they are");
+
+namespace cooked_detail {
+
+inline bool inside(const PakBlob& blob, uint64_t offset, uint64_t size) {
+    return offset <= blob.Size && size <= blob.Size - offset;
+}
+
+};
+
+// Read-only view of a Model blob. Nothing is copied; the arrays point into
+// the package.
+class CookedModel {
+public:
+    explicit CookedModel(const PakBlob& blob) : m_Blob(blob) {
+        m_Valid = blob.Type == PakBlobType::Model && validate();
+    }
+
+    bool valid() const {
+        return m_Valid;
+    }
+
+    const CookedModelHeader& header() const {
+        return *(const CookedModelHeader*) m_Blob.Data;
+    }
+
+    const CookedMesh& mesh(uint32_t i) const {
+        return meshes()[i];
+    }
+
+    const CookedTextureRef& textureRef(uint32_t i) const {
+        return ((const CookedTextureRef*) (meshes() + header().MeshCount))[i];
+    }
+
+    // header().VertexSize bytes per vertex
+    const void* vertices(const CookedMesh& mesh) const {
+        return m_Blob.Data + mesh.VertexOffset;
+    }
+
+    const uint32_t* indices(const CookedMesh& mesh) const {
+        return (const uint32_t*) (m_Blob.Data + mesh.IndexOffset);
+    }
+
+    const char* name() const {
+        return m_Blob.Name;
+    }
+
+private:
+    PakBlob m_Blob;
+    bool m_Valid = false;
+
+    const CookedMesh* meshes() const {
+        return (const CookedMesh*) (m_Blob.Data + sizeof(CookedModelHeader));
+    }
+
+    bool validate() const {
+        using cooked_detail::inside;
+        if (!inside(m_Blob, 0, sizeof(CookedModelHeader))) {
+            return false;
+        }
+        const CookedModelHeader& h = header();
+        uint64_t tables = (uint64_t) h.MeshCount * sizeof(CookedMesh) + (uint64_t) h.TextureRefCount * sizeof(CookedTextureRef);
+        if (h.VertexSize == 0 || !inside(m_Blob, sizeof(CookedModelHeader), tables)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < h.MeshCount; i++) {
+            const CookedMesh& m = mesh(i);
+            if (!inside(m_Blob, m.VertexOffset, (uint64_t) m.VertexCount * h.VertexSize) ||
+                !inside(m_Blob, m.IndexOffset, (uint64_t) m.IndexCount * sizeof(uint32_t)) ||
+                m.FirstTextureRef > h.TextureRefCount || m.TextureRefCount > h.TextureRefCount - m.FirstTextureRef) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Read-only view of a Texture blob.
+class CookedTexture {
+public:
+    explicit CookedTexture(const PakBlob& blob) : m_Blob(blob) {
+        m_Valid = blob.Type == PakBlobType::Texture && validate();
+    }
+
+    bool valid() const {
+        return m_Valid;
+    }
+
+    const CookedTextureHeader& header() const {
+        return *(const CookedTextureHeader*) m_Blob.Data;
+    }
+
+    bool compressed() const {
+        return header().Format == 0;
+    }
+
+    // False for compressed formats the driver does not list, S3TC on a
+    // driver without EXT_texture_compression_s3tc say.
+    bool uploadable() const {
+        if (!compressed()) {
+            return true;
+        }
+        static const std::vector<GLint> formats = [] {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+            std::vector<GLint> list(count);
+            if (count > 0) {
+                glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, list.data());
+            }
+            return list;
+        }();
+        return std::find(formats.begin(), formats.end(), (GLint) header().InternalFormat) != formats.end();
+    }
+
+    const CookedTextureLevel& level(uint32_t i) const {
+        return ((const CookedTextureLevel*) (m_Blob.Data + sizeof(CookedTextureHeader)))[i];
+    }
+
+    // the pixels of level i in the package
+    const unsigned char* levelData(uint32_t i) const {
+        return m_Blob.Data + level(i).Offset;
+    }
+
+    // Uploads levels [0, levels) into target of the texture bound to it, all
+    // through one pixel unpack buffer filled straight from the package. For
+    // an uncompressed texture internalFormat, when not 0, replaces the cooked
+    // one (GL_SRGB for colour data, say). Returns the number of levels
+    // uploaded.
+    uint32_t upload(GLenum target, uint32_t levels = ~0u, GLenum internalFormat = 0) const {
+        return uploadRange(target, 0, levels, internalFormat);
+    }
+
+    // Uploads levels [first, end) the way upload() does, for textures whose
+    // larger levels come later (TextureStreamer). Returns the number of levels
+    // uploaded.
+    uint32_t uploadRange(GLenum target, uint32_t first, uint32_t end, GLenum internalFormat = 0) const {
+        const CookedTextureHeader& h = header();
+        end = std::min(end, h.Levels);
+        if (first >= end) {
+            return 0;
+        }
+        // levels are stored consecutively, so the ones uploaded are one range
+        uint64_t begin = level(first).Offset;
+        uint64_t last = level(end - 1).Offset + level(end - 1).Size;
+        GLuint unpack = 0;
+        glGenBuffers(1, &unpack);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, last - begin, m_Blob.Data + begin, GL_STREAM_DRAW);
+        memoryTracker().bufferAllocated(unpack, last - begin, GL_STREAM_DRAW, MemoryCategory::Staging);
+        for (uint32_t i = first; i < end; i++) {
+            specify(target, i, (const void*) (uintptr_t) (level(i).Offset - begin), internalFormat);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // the driver keeps the storage until the uploads have read it
+        glDeleteBuffers(1, &unpack);
+        memoryTracker().bufferDeleted(unpack);
+        return end - first;
+    }
+
+    // Specifies level i of target from pixels, a pointer or an offset into
+    // the bound pixel unpack buffer.
+    void specify(GLenum target, uint32_t i, const void* pixels, GLenum internalFormat = 0) const {
+        const CookedTextureHeader& h = header();
+        const CookedTextureLevel& l = level(i);
+        if (compressed()) {
+            glCompressedTexImage2D(target, i, h.InternalFormat, l.Width, l.Height, 0, l.Size, pixels);
+            return;
+        }
+        // rows of RGB8 levels are tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(target, i, internalFormat ? internalFormat : h.InternalFormat, l.Width, l.Height, 0, h.Format,
+                     h.Type, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    // Frees level i of target again, keeping the texture complete as long as
+    // GL_TEXTURE_BASE_LEVEL is above it.
+    void release(GLenum target, uint32_t i, GLenum internalFormat = 0) const {
+        const CookedTextureHeader& h = header();
+        if (compressed()) {
+            glCompressedTexImage2D(target, i, h.InternalFormat, 0, 0, 0, 0, nullptr);
+        } else {
+            glTexImage2D(target, i, internalFormat ? internalFormat : h.InternalFormat, 0, 0, 0, h.Format, h.Type,
+                         nullptr);
+        }
+    }
+
+    // Reports levels [first, end) of target of texture, as specified with
+    // internalFormat, to rg::memoryTracker().
+    void track(GLuint texture, GLenum target, uint32_t first, uint32_t end, GLenum internalFormat = 0) const {
+        const CookedTextureHeader& h = header();
+        for (uint32_t i = first; i < std::min(end, h.Levels); i++) {
+            const CookedTextureLevel& l = level(i);
+            memoryTracker().textureLevelAllocated(texture, target, i,
+                                                  internalFormat ? internalFormat : h.InternalFormat, l.Width,
+                                                  l.Height, compressed() ? l.Size : 0, MemoryCategory::Texture);
+        }
+    }
+
+private:
+    PakBlob m_Blob;
+    bool m_Valid = false;
+
+    bool validate() const {
+        using cooked_detail::inside;
+        if (!inside(m_Blob, 0, sizeof(CookedTextureHeader))) {
+            return false;
+        }
+        const CookedTextureHeader& h = header();
+        if (h.Levels == 0 || !inside(m_Blob, sizeof(CookedTextureHeader), (uint64_t) h.Levels * sizeof(CookedTextureLevel))) {
+            return false;
+        }
+        for (uint32_t i = 0; i < h.Levels; i++) {
+            const CookedTextureLevel& l = level(i);
+            if (!inside(m_Blob, l.Offset, l.Size) || (i > 0 && l.Offset != level(i - 1).Offset + level(i - 1).Size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_COOKEDASSETS_H
@@ -0,0 +1,42 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_DRAWSTATS_H
+#define PROJECT_BASE_DRAWSTATS_H
+
+#include <glad/glad.h>
+
+namespace rg {
+
+// Draw calls and primitives submitted since the last reset, counted by hand at
+// every draw site since GL 3.3 has no pipeline statistics queries.
+struct DrawStats {
+    unsigned long long drawCalls = 0;
+    unsigned long long triangles = 0;
+
+    void reset() {
+        drawCalls = 0;
+        triangles = 0;
+    }
+};
+
+inline DrawStats& drawStats() {
+    static DrawStats stats;
+    return stats;
+}
+
+// Call next to each glDraw* with the same mode and vertex/index count.
+inline void countDraw(GLenum mode, GLsizei count) {
+    DrawStats& stats = drawStats();
+    ++stats.drawCalls;
+    if (mode == GL_TRIANGLES) {
+        stats.triangles += count / 3;
+    } else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) {
+        stats.triangles += count > 2 ? count - 2 : 0;
+    }
+}
+
+};
+
+#endif //PROJECT_BASE_DRAWSTATS_H
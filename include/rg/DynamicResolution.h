@@ -0,0 +1,60 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_DYNAMICRESOLUTION_H
+#define PROJECT_BASE_DYNAMICRESOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace rg {
+
+// Picks the render scale (fraction of the window size per axis) that keeps measured
+// GPU frame time at TargetMs. GPU cost is treated as proportional to the pixel count,
+// i.e. to scale^2, so the ideal scale is scale * sqrt(target / measured). The step
+// towards it is damped and ignored inside a small dead band so the resolution does
+// not oscillate frame to frame.
+class DynamicResolution {
+public:
+    bool Enabled = true;
+    float TargetMs = 16.6f;
+    float MinScale = 0.5f;
+    float MaxScale = 1.0f;
+    float Damping = 0.15f;
+    float DeadBand = 0.05f;
+
+    void update(double gpuMs) {
+        m_GpuMs = (float) gpuMs;
+        if (!Enabled) {
+            m_Scale = MaxScale;
+            return;
+        }
+        if (gpuMs <= 0.0) {
+            return;
+        }
+        float error = (float) (TargetMs / gpuMs);
+        if (std::fabs(error - 1.0f) < DeadBand) {
+            return;
+        }
+        float ideal = m_Scale * std::sqrt(error);
+        m_Scale += (ideal - m_Scale) * Damping;
+        m_Scale = std::min(MaxScale, std::max(MinScale, m_Scale));
+    }
+
+    float scale() const {
+        return m_Scale;
+    }
+
+    float lastGpuMs() const {
+        return m_GpuMs;
+    }
+
+private:
+    float m_Scale = 1.0f;
+    float m_GpuMs = 0.0f;
+};
+
+};
+
+#endif //PROJECT_BASE_DYNAMICRESOLUTION_H
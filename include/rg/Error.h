@@ -7,26 +7,35 @@
 
 #include <iostream>
 #include <glad/glad.h>
+#include <rg/GLDebug.h>
 
 #define LOG(stream) stream << "[" << __FILE__ << ", " << __func__ << ", " << __LINE__ << "] "
 #define BREAK_IF_FALSE(x) if (!(x)) __builtin_trap()
 #define ASSERT(x, msg) do { if (!(x)) { std::cerr << msg << '\n'; BREAK_IF_FALSE(false); } } while(0)
+// Builds without RG_GL_DEBUG (the CMake option) get the bare call. With it the
+// call is surrounded by glGetError polling, which stalls the pipeline, unless
+// KHR_debug output is installed (see GLDebug.h) and the driver reports errors
+// by itself.
+#ifndef RG_GL_DEBUG
+#define GLCALL(x) do { x; } while (0)
+#else
 #define GLCALL(x) \
-do{ rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } while (0)
+do{ if (rg::glDebug().active()) { x; } else { rg::clearAllOpenGlErrors(); x; BREAK_IF_FALSE(rg::wasPreviousOpenGLCallSuccessful(__FILE__, __LINE__, #x)); } } while (0)
+#endif
 
 namespace rg {
 
     
-void clearAllOpenGlErrors();
-const char* openGLErrorToString(GLenum error);
-bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call);
+inline void clearAllOpenGlErrors();
+inline const char* openGLErrorToString(GLenum error);
+inline bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call);
 
-    void clearAllOpenGlErrors() {
+    inline void clearAllOpenGlErrors() {
         while (glGetError() != GL_NO_ERROR) {
             ;
         }
     }
-    const char* openGLErrorToString(GLenum error) {
+    inline const char* openGLErrorToString(GLenum error) {
         switch(error) {
             case GL_NO_ERROR: return "GL_NO_ERROR";
             case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
@@ -37,7 +46,7 @@ bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* cal
         ASSERT(false, "Passed something that is not an error code");
         return "THIS_SHOULD_NEVER_HAPPEN";
     }
-    bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call) {
+    inline bool wasPreviousOpenGLCallSuccessful(const char* file, int line, const char* call) {
         bool success = true;
         while (GLenum error = glGetError()) {
             std::cerr << "[OpenGL error] " << error << " " << openGLErrorToString(error)
@@ -0,0 +1,140 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FILEWATCHER_H
+#define PROJECT_BASE_FILEWATCHER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace rg {
+
+// Reports which of a set of files have been written, without blocking.
+//
+// On Linux one inotify instance watches the directories of the files, so
+// editors that save by writing a temporary file and renaming it over the
+// original are caught as well; changes() only reads the events that are
+// already queued. Elsewhere changes() compares modification times.
+//
+//   watcher.watch("resources/shaders/lit.fs");
+//   for (const std::string& path : watcher.changes()) ...
+class FileWatcher {
+public:
+    FileWatcher() = default;
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    ~FileWatcher() {
+        close();
+    }
+
+    // Returns false when the file cannot be watched; it is then never reported.
+    bool watch(const std::string& path) {
+        if (m_Files.count(path)) {
+            return true;
+        }
+#ifdef __linux__
+        if (m_Fd < 0) {
+            m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (m_Fd < 0) {
+                std::cerr << "FileWatcher: inotify_init1 failed, errno " << errno << '\n';
+                return false;
+            }
+        }
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        if (std::find_if(m_Directories.begin(), m_Directories.end(),
+                         [&](const std::pair<const int, std::string>& entry) {
+                             return entry.second == directory;
+                         }) == m_Directories.end()) {
+            const char* watched = directory.empty() ? "." : directory.c_str();
+            int wd = inotify_add_watch(m_Fd, watched, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd < 0) {
+                std::cerr << "FileWatcher: cannot watch " << watched << ", errno " << errno << '\n';
+                return false;
+            }
+            m_Directories[wd] = directory;
+        }
+        m_Files[path] = 0;
+#else
+        m_Files[path] = modificationTime(path);
+#endif
+        return true;
+    }
+
+    // Watched files written since the last call, each reported once.
+    std::vector<std::string> changes() {
+        std::set<std::string> changed;
+#ifdef __linux__
+        if (m_Fd < 0) {
+            return {};
+        }
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(m_Fd, buffer, sizeof(buffer))) > 0) {
+            for (char* event = buffer; event < buffer + length;) {
+                const inotify_event* header = (const inotify_event*) event;
+                auto directory = m_Directories.find(header->wd);
+                if (header->len > 0 && directory != m_Directories.end()) {
+                    std::string path = directory->second + header->name;
+                    if (m_Files.count(path)) {
+                        changed.insert(path);
+                    }
+                }
+                event += sizeof(inotify_event) + header->len;
+            }
+        }
+#else
+        for (auto& file : m_Files) {
+            long long time = modificationTime(file.first);
+            if (time != file.second) {
+                file.second = time;
+                changed.insert(file.first);
+            }
+        }
+#endif
+        return std::vector<std::string>(changed.begin(), changed.end());
+    }
+
+    void close() {
+#ifdef __linux__
+        if (m_Fd >= 0) {
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+        m_Directories.clear();
+#endif
+        m_Files.clear();
+    }
+
+private:
+    // watched path -> last modification time (unused with inotify)
+    std::map<std::string, long long> m_Files;
+#ifdef __linux__
+    int m_Fd = -1;
+    // watch descriptor -> directory prefix of the watched paths, with the
+    // trailing slash, so event names append to it
+    std::map<int, std::string> m_Directories;
+#else
+    static long long modificationTime(const std::string& path) {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 ? (long long) info.st_mtime : 0;
+    }
+#endif
+};
+
+};
+
+#endif //PROJECT_BASE_FILEWATCHER_H
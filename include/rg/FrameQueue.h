@@ -0,0 +1,85 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRAMEQUEUE_H
+#define PROJECT_BASE_FRAMEQUEUE_H
+
+#include <condition_variable>
+#include <mutex>
+
+namespace rg {
+
+// Hands frames from the thread that simulates them to the thread that renders
+// them. Frames are filled in place in one of kSlots slots: while the renderer
+// reads one, the producer can have one more published and be writing a third,
+// so simulation of frame N + 1 overlaps submission of frame N and the producer
+// never runs more than two frames ahead.
+//
+//   producer:                           consumer:
+//   T* frame = queue.beginWrite();      while (T* frame = queue.acquire()) {
+//   ... fill *frame ...                     ... render *frame ...
+//   queue.publish();                        queue.release();
+//                                       }
+//
+// A slot belongs to exactly one side between those calls, so nothing in T needs
+// to be synchronised.
+template<typename T, int kSlots = 3>
+class FrameQueue {
+public:
+    // Waits for a free slot. Returns nullptr once the queue is closed.
+    T* beginWrite() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Closed || m_Filled < kSlots; });
+        return m_Closed ? nullptr : &m_Slots[m_Write];
+    }
+
+    void publish() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Write = (m_Write + 1) % kSlots;
+            ++m_Filled;
+        }
+        m_Condition.notify_all();
+    }
+
+    // Waits for the oldest published frame. Returns nullptr once the queue is
+    // closed and every published frame has been consumed.
+    T* acquire() {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Condition.wait(lock, [this] { return m_Closed || m_Filled > 0; });
+        return m_Filled > 0 ? &m_Slots[m_Read] : nullptr;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Read = (m_Read + 1) % kSlots;
+            --m_Filled;
+        }
+        m_Condition.notify_all();
+    }
+
+    // Wakes both sides; the consumer still gets the frames already published.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Closed = true;
+        }
+        m_Condition.notify_all();
+    }
+
+private:
+    T m_Slots[kSlots];
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    int m_Write = 0;
+    int m_Read = 0;
+    // published frames not yet released, including the one being rendered
+    int m_Filled = 0;
+    bool m_Closed = false;
+};
+
+};
+
+#endif //PROJECT_BASE_FRAMEQUEUE_H
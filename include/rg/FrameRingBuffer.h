@@ -0,0 +1,243 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_FRAMERINGBUFFER_H
+#define PROJECT_BASE_FRAMERINGBUFFER_H
+
+#include <glad/glad.h>
+#include <rg/Align.h>
+#include <rg/GLExtensions.h>
+#include <rg/GLState.h>
+#include <rg/MemoryTracker.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// ARB_buffer_storage (core in 4.4) is not part of the generated 3.3 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace rg {
+
+// A sub-range of the ring handed out for the current frame. data is where the
+// CPU writes, offset is what glBindBufferRange / glVertexAttribPointer take.
+struct FrameAllocation {
+    void* data = nullptr;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+};
+
+// One buffer object for all data that changes every frame, split into kFrames
+// regions. Each frame bump-allocates from its own region and the GPU reads the
+// region while the CPU fills the next one; a fence placed at the end of the
+// frame keeps the CPU from overwriting a region kFrames frames later before
+// the GPU has finished with it. Nothing is orphaned or copied by the driver.
+//
+// With ARB_buffer_storage the whole buffer stays mapped persistent and coherent
+// for its lifetime. On plain 3.3 the current region is mapped unsynchronized
+// (the fence already did the synchronisation) and unmapped by flush(), which
+// therefore has to be called before draws that read what was written:
+//
+//   ring.beginFrame();
+//   rg::FrameAllocation camera = ring.write(frameCamera);
+//   ring.flush();
+//   ring.bindRange(GL_UNIFORM_BUFFER, 0, camera);
+//   ... draw ...
+//   ring.endFrame();
+class FrameRingBuffer {
+public:
+    static const int kFrames = 3;
+
+    // frameSize is the space available to a single frame.
+    bool init(GLsizeiptr frameSize, GLADloadproc load) {
+        destroy();
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_UniformAlignment = alignment > 0 ? alignment : 256;
+        // regions start aligned so offsets within them only need the local alignment
+        m_FrameSize = alignUp(frameSize, std::max<GLsizeiptr>(256, m_UniformAlignment));
+
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        if (hasExtension("GL_ARB_buffer_storage")) {
+            m_BufferStorage = (BufferStorageProc) load("glBufferStorage");
+        }
+        if (m_BufferStorage) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            m_BufferStorage(GL_COPY_WRITE_BUFFER, m_FrameSize * kFrames, nullptr, flags);
+            m_Persistent = (char*) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_FrameSize * kFrames, flags);
+        }
+        if (!m_Persistent) {
+            glBufferData(GL_COPY_WRITE_BUFFER, m_FrameSize * kFrames, nullptr, GL_STREAM_DRAW);
+        }
+        memoryTracker().bufferAllocated(m_Buffer, m_FrameSize * kFrames, GL_STREAM_DRAW, MemoryCategory::Uniform,
+                                        "Frame ring buffer");
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return glGetError() == GL_NO_ERROR;
+    }
+
+    void destroy() {
+        if (m_Buffer) {
+            unmapRegion();
+            for (GLsync& fence : m_Fences) {
+                if (fence) {
+                    glDeleteSync(fence);
+                    fence = nullptr;
+                }
+            }
+            if (m_Persistent) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+                m_Persistent = nullptr;
+            }
+            glDeleteBuffers(1, &m_Buffer);
+            glState().bufferDeleted(m_Buffer);
+            memoryTracker().bufferDeleted(m_Buffer);
+            m_Buffer = 0;
+        }
+    }
+
+    // Waits until the GPU is done with the region this frame is going to reuse.
+    void beginFrame() {
+        GLsync& fence = m_Fences[m_Region];
+        if (fence) {
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                // the CPU is kFrames ahead, this is where it has to wait
+                ++m_Stalls;
+                while (result == GL_TIMEOUT_EXPIRED) {
+                    result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                }
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        m_Head = 0;
+        m_Overflowed = false;
+    }
+
+    // Bump allocation from the current frame's region. Returns an allocation
+    // with data == nullptr when the region is full.
+    FrameAllocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16) {
+        FrameAllocation allocation;
+        GLsizeiptr begin = alignUp(m_Head, alignment);
+        if (begin + size > m_FrameSize) {
+            if (!m_Overflowed) {
+                std::cerr << "FrameRingBuffer: frame region of " << m_FrameSize << " bytes is full" << std::endl;
+                m_Overflowed = true;
+            }
+            return allocation;
+        }
+        char* base = m_Persistent ? m_Persistent + regionOffset() : mapRegion(begin);
+        if (!base) {
+            return allocation;
+        }
+        m_Head = begin + size;
+        allocation.data = base + begin;
+        allocation.offset = regionOffset() + begin;
+        allocation.size = size;
+        return allocation;
+    }
+
+    // Allocation aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...).
+    FrameAllocation allocateUniform(GLsizeiptr size) {
+        return allocate(size, m_UniformAlignment);
+    }
+
+    template<typename T>
+    FrameAllocation write(const T& value, bool uniform = true) {
+        FrameAllocation allocation = uniform ? allocateUniform(sizeof(T)) : allocate(sizeof(T));
+        if (allocation.data) {
+            std::memcpy(allocation.data, &value, sizeof(T));
+        }
+        return allocation;
+    }
+
+    // Makes everything written so far visible to the GPU. A no-op for the
+    // persistent coherent mapping; unmaps the region on the 3.3 path, later
+    // allocations of the same frame map the rest of it again.
+    void flush() {
+        unmapRegion();
+    }
+
+    void bindRange(GLenum target, GLuint index, const FrameAllocation& allocation) const {
+        if (target == GL_UNIFORM_BUFFER) {
+            glState().bindUniformBuffer(index, m_Buffer, allocation.offset, allocation.size);
+        } else {
+            glBindBufferRange(target, index, m_Buffer, allocation.offset, allocation.size);
+        }
+    }
+
+    // Call after the last draw reading this frame's data.
+    void endFrame() {
+        unmapRegion();
+        m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_Region = (m_Region + 1) % kFrames;
+    }
+
+    GLuint buffer() const { return m_Buffer; }
+    bool persistent() const { return m_Persistent != nullptr; }
+    GLsizeiptr frameSize() const { return m_FrameSize; }
+    GLsizeiptr used() const { return m_Head; }
+    // frames on which beginFrame() had to wait for the GPU
+    unsigned long long stalls() const { return m_Stalls; }
+
+private:
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    BufferStorageProc m_BufferStorage = nullptr;
+    GLuint m_Buffer = 0;
+    GLsizeiptr m_FrameSize = 0;
+    GLint m_UniformAlignment = 256;
+    char* m_Persistent = nullptr;
+    GLsync m_Fences[kFrames] = {};
+    int m_Region = 0;
+    GLsizeiptr m_Head = 0;
+    bool m_Overflowed = false;
+    unsigned long long m_Stalls = 0;
+    // 3.3 path: the mapped part of the current region, starting at m_MapBegin
+    char* m_Mapped = nullptr;
+    GLsizeiptr m_MapBegin = 0;
+
+    GLintptr regionOffset() const {
+        return (GLintptr) m_Region * m_FrameSize;
+    }
+
+    // Returns a pointer that corresponds to the start of the region.
+    char* mapRegion(GLsizeiptr begin) {
+        if (!m_Mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                               GL_MAP_FLUSH_EXPLICIT_BIT;
+            m_Mapped = (char*) glMapBufferRange(GL_COPY_WRITE_BUFFER, regionOffset() + begin, m_FrameSize - begin,
+                                                flags);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            if (!m_Mapped) {
+                return nullptr;
+            }
+            m_MapBegin = begin;
+        }
+        return m_Mapped - m_MapBegin;
+    }
+
+    void unmapRegion() {
+        if (!m_Mapped) {
+            return;
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        if (m_Head > m_MapBegin) {
+            glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, m_Head - m_MapBegin);
+        }
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        m_Mapped = nullptr;
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_FRAMERINGBUFFER_H
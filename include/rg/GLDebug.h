@@ -0,0 +1,216 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GLDEBUG_H
+#define PROJECT_BASE_GLDEBUG_H
+
+#include <glad/glad.h>
+#include <rg/GLExtensions.h>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+// KHR_debug (core in 4.3) is not part of the generated 3.3 loader
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#endif
+
+namespace rg {
+
+enum class GLDebugSeverity {
+    Notification,
+    Low,
+    Medium,
+    High
+};
+
+struct GLDebugOptions {
+    // Report messages from inside the offending call. Makes the call stack of
+    // the callback useful at the cost of serialising the driver.
+    bool Synchronous = false;
+    GLDebugSeverity MinSeverity = GLDebugSeverity::Low;
+    // GL_DONT_CARE or one GL_DEBUG_SOURCE_* / GL_DEBUG_TYPE_* value
+    GLenum Source = GL_DONT_CARE;
+    GLenum Type = GL_DONT_CARE;
+    // stop in the debugger on GL_DEBUG_TYPE_ERROR
+    bool BreakOnError = false;
+};
+
+struct GLDebugMessageStats {
+    unsigned long long count = 0;
+    GLenum source = 0;
+    GLenum type = 0;
+    GLenum severity = 0;
+    std::string firstMessage;
+};
+
+// Driver-side error reporting through KHR_debug. The driver calls back only
+// when something is wrong, so unlike glGetError polling it costs nothing per
+// call and never waits for the GPU. Each message id is printed the first time
+// it is seen and counted after that.
+// Needs a debug context (GLFW_OPENGL_DEBUG_CONTEXT) and the extension; on other
+// contexts install() returns false and GLCALL falls back to glGetError in
+// RG_GL_DEBUG builds.
+class GLDebug {
+public:
+    bool install(GLADloadproc load, const GLDebugOptions& options = GLDebugOptions()) {
+        GLint flags = 0;
+        glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT) || !hasExtension("GL_KHR_debug")) {
+            return false;
+        }
+        m_DebugMessageCallback = (DebugMessageCallbackProc) load("glDebugMessageCallback");
+        m_DebugMessageControl = (DebugMessageControlProc) load("glDebugMessageControl");
+        if (!m_DebugMessageCallback || !m_DebugMessageControl) {
+            return false;
+        }
+        m_Options = options;
+
+        glEnable(GL_DEBUG_OUTPUT);
+        if (options.Synchronous) {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        }
+        // start from nothing and enable the requested severities, the driver
+        // then does not even format the filtered messages
+        m_DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+        static const GLenum severities[] = {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW,
+                                            GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH};
+        for (int i = (int) options.MinSeverity; i < 4; i++) {
+            m_DebugMessageControl(options.Source, options.Type, severities[i], 0, nullptr, GL_TRUE);
+        }
+        m_DebugMessageCallback(&GLDebug::callback, this);
+        m_Active = true;
+        return true;
+    }
+
+    bool active() const {
+        return m_Active;
+    }
+
+    // Silences a message id that is known and accepted, e.g. driver chatter.
+    void ignore(GLuint id) {
+        if (m_Active) {
+            m_DebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 1, &id, GL_FALSE);
+        }
+    }
+
+    std::map<GLuint, GLDebugMessageStats> messageStats() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    void printSummary() const {
+        std::map<GLuint, GLDebugMessageStats> stats = messageStats();
+        if (stats.empty()) {
+            return;
+        }
+        std::cerr << "[OpenGL debug] message counts:\n";
+        for (const auto& entry : stats) {
+            std::cerr << "  id " << entry.first << " (" << severityName(entry.second.severity) << ", "
+                      << typeName(entry.second.type) << "): " << entry.second.count << "x " << entry.second.firstMessage
+                      << "\n";
+        }
+    }
+
+    static const char* sourceName(GLenum source) {
+        switch (source) {
+            case GL_DEBUG_SOURCE_API: return "API";
+            case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+            case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+            case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+            case GL_DEBUG_SOURCE_APPLICATION: return "application";
+            default: return "other";
+        }
+    }
+
+    static const char* typeName(GLenum type) {
+        switch (type) {
+            case GL_DEBUG_TYPE_ERROR: return "error";
+            case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+            case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+            case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+            case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+            case GL_DEBUG_TYPE_MARKER: return "marker";
+            default: return "other";
+        }
+    }
+
+    static const char* severityName(GLenum severity) {
+        switch (severity) {
+            case GL_DEBUG_SEVERITY_HIGH: return "high";
+            case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+            case GL_DEBUG_SEVERITY_LOW: return "low";
+            default: return "notification";
+        }
+    }
+
+private:
+    typedef void (APIENTRYP DebugMessageCallbackProc)(GLDEBUGPROC callback, const void* userParam);
+    typedef void (APIENTRYP DebugMessageControlProc)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+                                                     const GLuint* ids, GLboolean enabled);
+
+    DebugMessageCallbackProc m_DebugMessageCallback = nullptr;
+    DebugMessageControlProc m_DebugMessageControl = nullptr;
+    GLDebugOptions m_Options;
+    bool m_Active = false;
+    // without GL_DEBUG_OUTPUT_SYNCHRONOUS the driver may call from its own threads
+    mutable std::mutex m_Mutex;
+    std::map<GLuint, GLDebugMessageStats> m_Stats;
+
+    static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+                                  const GLchar* message, const void* userParam) {
+        GLDebug* debug = (GLDebug*) userParam;
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(debug->m_Mutex);
+            GLDebugMessageStats& stats = debug->m_Stats[id];
+            first = stats.count++ == 0;
+            if (first) {
+                stats.source = source;
+                stats.type = type;
+                stats.severity = severity;
+                stats.firstMessage.assign(message, length >= 0 ? length : std::strlen(message));
+            }
+        }
+        if (first) {
+            std::cerr << "[OpenGL debug] " << severityName(severity) << " " << typeName(type) << " from "
+                      << sourceName(source) << ", id " << id << ": " << message << std::endl;
+        }
+        if (type == GL_DEBUG_TYPE_ERROR && debug->m_Options.BreakOnError) {
+            __builtin_trap();
+        }
+    }
+};
+
+inline GLDebug& glDebug() {
+    static GLDebug instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_GLDEBUG_H
@@ -0,0 +1,459 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_GLSTATE_H
+#define PROJECT_BASE_GLSTATE_H
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+// state changes requested through GLState since the last reset
+struct GLStateStats {
+    unsigned long long calls = 0;
+    // requests that matched the shadow and never reached the driver
+    unsigned long long skipped = 0;
+    // shadow values found to differ from the context while validating
+    unsigned long long drifts = 0;
+
+    void reset() {
+        calls = 0;
+        skipped = 0;
+        drifts = 0;
+    }
+};
+
+// Shadow copy of the context state the renderer changes all the time:
+// capabilities, depth/blend/stencil functions, the depth mask, the program, the VAO, textures
+// per unit, uniform buffer ranges, framebuffers and the viewport. Changes are routed through here
+// instead of straight to GL, and a change to the value already set is dropped.
+//
+// Everything starts out unknown, so the first change of each state always goes
+// through. Code that changes state behind GLState's back has to call
+// invalidate() afterwards, and deleting an object has to be reported since GL
+// silently unbinds it. With Validate set, every dropped change is checked
+// against glGet*, which is slow but catches the shadow drifting from the
+// context; drifts are printed once per state, counted and corrected.
+//
+// Only for the thread that owns the context.
+class GLState {
+public:
+    bool Validate = false;
+
+    // texture units whose bindings are tracked, higher ones always go to GL
+    static const int kTextureUnits = 16;
+    // uniform buffer binding points whose ranges are tracked
+    static const int kUniformBindings = 8;
+
+    void invalidate() {
+        m_Caps.clear();
+        m_DepthFunc = kUnknown;
+        m_BlendFunc[0] = kUnknown;
+        m_DepthMask = kUnknown;
+        m_StencilFunc[0] = kUnknown;
+        m_StencilMask = kUnknown;
+        m_StencilOp[0] = kUnknown;
+        m_CullFace = kUnknown;
+        m_FrontFace = kUnknown;
+        m_Program = kUnknown;
+        m_VertexArray = kUnknown;
+        m_ActiveUnit = kUnknown;
+        for (Unit& unit : m_Units) {
+            unit.texture2D = kUnknown;
+            unit.cubeMap = kUnknown;
+        }
+        for (UniformRange& range : m_UniformBuffers) {
+            range.buffer = kUnknown;
+        }
+        m_DrawFramebuffer = kUnknown;
+        m_ReadFramebuffer = kUnknown;
+        m_Viewport[0] = (GLint) kUnknown;
+    }
+
+    void enable(GLenum cap) { set(cap, true); }
+    void disable(GLenum cap) { set(cap, false); }
+
+    void set(GLenum cap, bool enabled) {
+        ++m_Stats.calls;
+        for (std::pair<GLenum, bool>& known : m_Caps) {
+            if (known.first == cap) {
+                if (filtered(known.second == enabled && consistentCap(cap, enabled))) {
+                    return;
+                }
+                known.second = enabled;
+                enabled ? glEnable(cap) : glDisable(cap);
+                return;
+            }
+        }
+        m_Caps.emplace_back(cap, enabled);
+        enabled ? glEnable(cap) : glDisable(cap);
+    }
+
+    void depthFunc(GLenum func) {
+        if (filtered(unchanged(m_DepthFunc, func) && consistent(GL_DEPTH_FUNC, func, "depth func"))) {
+            return;
+        }
+        glDepthFunc(func);
+    }
+
+    void blendFunc(GLenum src, GLenum dst) {
+        blendFuncSeparate(src, dst, src, dst);
+    }
+
+    void blendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+        GLuint value[4] = {srcRGB, dstRGB, srcAlpha, dstAlpha};
+        ++m_Stats.calls;
+        if (filtered(std::equal(value, value + 4, m_BlendFunc) && consistent(GL_BLEND_SRC_RGB, srcRGB, "blend func") &&
+                     consistent(GL_BLEND_DST_RGB, dstRGB, "blend func") &&
+                     consistent(GL_BLEND_SRC_ALPHA, srcAlpha, "blend func") &&
+                     consistent(GL_BLEND_DST_ALPHA, dstAlpha, "blend func"))) {
+            return;
+        }
+        std::copy(value, value + 4, m_BlendFunc);
+        glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    }
+
+    void depthMask(bool write) {
+        if (filtered(unchanged(m_DepthMask, write) && consistent(GL_DEPTH_WRITEMASK, write, "depth mask"))) {
+            return;
+        }
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void stencilFunc(GLenum func, GLint ref, GLuint mask) {
+        GLuint value[3] = {func, (GLuint) ref, mask};
+        if (filtered(unchanged(m_StencilFunc, value) && consistent(GL_STENCIL_FUNC, func, "stencil func") &&
+                     consistent(GL_STENCIL_REF, ref, "stencil ref") &&
+                     consistent(GL_STENCIL_VALUE_MASK, mask, "stencil value mask"))) {
+            return;
+        }
+        glStencilFunc(func, ref, mask);
+    }
+
+    void stencilMask(GLuint mask) {
+        if (filtered(unchanged(m_StencilMask, mask) && consistent(GL_STENCIL_WRITEMASK, mask, "stencil write mask"))) {
+            return;
+        }
+        glStencilMask(mask);
+    }
+
+    void stencilOp(GLenum stencilFail, GLenum depthFail, GLenum pass) {
+        GLuint value[3] = {stencilFail, depthFail, pass};
+        if (filtered(unchanged(m_StencilOp, value) && consistent(GL_STENCIL_FAIL, stencilFail, "stencil op") &&
+                     consistent(GL_STENCIL_PASS_DEPTH_FAIL, depthFail, "stencil op") &&
+                     consistent(GL_STENCIL_PASS_DEPTH_PASS, pass, "stencil op"))) {
+            return;
+        }
+        glStencilOp(stencilFail, depthFail, pass);
+    }
+
+    void cullFace(GLenum mode) {
+        if (filtered(unchanged(m_CullFace, mode) && consistent(GL_CULL_FACE_MODE, mode, "cull face"))) {
+            return;
+        }
+        glCullFace(mode);
+    }
+
+    void frontFace(GLenum mode) {
+        if (filtered(unchanged(m_FrontFace, mode) && consistent(GL_FRONT_FACE, mode, "front face"))) {
+            return;
+        }
+        glFrontFace(mode);
+    }
+
+    void useProgram(GLuint program) {
+        if (filtered(unchanged(m_Program, program) && consistent(GL_CURRENT_PROGRAM, program, "program"))) {
+            return;
+        }
+        glUseProgram(program);
+    }
+
+    void bindVertexArray(GLuint vao) {
+        if (filtered(unchanged(m_VertexArray, vao) && consistent(GL_VERTEX_ARRAY_BINDING, vao, "vertex array"))) {
+            return;
+        }
+        glBindVertexArray(vao);
+    }
+
+    // unit is the index, not GL_TEXTURE0 + index
+    void activeTexture(GLuint unit) {
+        if (filtered(unchanged(m_ActiveUnit, unit) &&
+                     consistent(GL_ACTIVE_TEXTURE, GL_TEXTURE0 + unit, "active texture"))) {
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // Binds texture to target on unit, switching the active unit only when the
+    // binding actually changes. The active unit is left wherever it ends up.
+    void bindTexture(GLuint unit, GLenum target, GLuint texture) {
+        GLuint* shadow = textureSlot(unit, target);
+        if (!shadow) {
+            ++m_Stats.calls;
+        } else if (unchanged(*shadow, texture)) {
+            if (!Validate) {
+                filtered(true);
+                return;
+            }
+            // the binding can only be queried for the active unit
+            activeTexture(unit);
+            GLenum binding = target == GL_TEXTURE_2D ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_CUBE_MAP;
+            if (filtered(consistent(binding, texture, "texture binding"))) {
+                return;
+            }
+        }
+        activeTexture(unit);
+        glBindTexture(target, texture);
+    }
+
+    // glBindBufferRange on a GL_UNIFORM_BUFFER binding point. The generic
+    // GL_UNIFORM_BUFFER binding it also sets is not tracked.
+    void bindUniformBuffer(GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        ++m_Stats.calls;
+        if (index < (GLuint) kUniformBindings) {
+            UniformRange& shadow = m_UniformBuffers[index];
+            if (filtered(shadow.buffer == buffer && shadow.offset == offset && shadow.size == size &&
+                         consistentUniformBuffer(index, shadow))) {
+                return;
+            }
+            shadow = {buffer, offset, size};
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+    }
+
+    // GL_FRAMEBUFFER sets both the draw and the read binding.
+    void bindFramebuffer(GLenum target, GLuint framebuffer) {
+        ++m_Stats.calls;
+        bool draw = target != GL_READ_FRAMEBUFFER;
+        bool read = target != GL_DRAW_FRAMEBUFFER;
+        if (filtered((!draw || (m_DrawFramebuffer == framebuffer &&
+                                consistent(GL_DRAW_FRAMEBUFFER_BINDING, framebuffer, "draw framebuffer"))) &&
+                     (!read || (m_ReadFramebuffer == framebuffer &&
+                                consistent(GL_READ_FRAMEBUFFER_BINDING, framebuffer, "read framebuffer"))))) {
+            return;
+        }
+        if (draw) {
+            m_DrawFramebuffer = framebuffer;
+        }
+        if (read) {
+            m_ReadFramebuffer = framebuffer;
+        }
+        glBindFramebuffer(target, framebuffer);
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        ++m_Stats.calls;
+        GLint value[4] = {x, y, width, height};
+        if (filtered(std::equal(value, value + 4, m_Viewport) && consistentViewport(value))) {
+            return;
+        }
+        std::copy(value, value + 4, m_Viewport);
+        glViewport(x, y, width, height);
+    }
+
+    // GL unbinds deleted objects, the shadow has to follow
+    void textureDeleted(GLuint texture) {
+        for (Unit& unit : m_Units) {
+            if (unit.texture2D == texture) {
+                unit.texture2D = 0;
+            }
+            if (unit.cubeMap == texture) {
+                unit.cubeMap = 0;
+            }
+        }
+    }
+
+    void bufferDeleted(GLuint buffer) {
+        for (UniformRange& range : m_UniformBuffers) {
+            if (range.buffer == buffer) {
+                range = {0, 0, 0};
+            }
+        }
+    }
+
+    void framebufferDeleted(GLuint framebuffer) {
+        if (m_DrawFramebuffer == framebuffer) {
+            m_DrawFramebuffer = 0;
+        }
+        if (m_ReadFramebuffer == framebuffer) {
+            m_ReadFramebuffer = 0;
+        }
+    }
+
+    void vertexArrayDeleted(GLuint vao) {
+        if (m_VertexArray == vao) {
+            m_VertexArray = 0;
+        }
+    }
+
+    // a program in use stays in use until another one replaces it, but its
+    // name may be reused
+    void programDeleted(GLuint program) {
+        if (m_Program == program) {
+            m_Program = kUnknown;
+        }
+    }
+
+    const GLStateStats& stats() const {
+        return m_Stats;
+    }
+
+    void resetStats() {
+        m_Stats.reset();
+    }
+
+private:
+    static const GLuint kUnknown = 0xFFFFFFFFu;
+
+    struct Unit {
+        GLuint texture2D = kUnknown;
+        GLuint cubeMap = kUnknown;
+    };
+
+    struct UniformRange {
+        GLuint buffer = kUnknown;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    std::vector<std::pair<GLenum, bool>> m_Caps;
+    GLuint m_DepthFunc = kUnknown;
+    GLuint m_BlendFunc[4] = {kUnknown, 0, 0, 0};
+    GLuint m_DepthMask = kUnknown;
+    GLuint m_StencilFunc[3] = {kUnknown, 0, 0};
+    GLuint m_StencilMask = kUnknown;
+    GLuint m_StencilOp[3] = {kUnknown, 0, 0};
+    GLuint m_CullFace = kUnknown;
+    GLuint m_FrontFace = kUnknown;
+    GLuint m_Program = kUnknown;
+    GLuint m_VertexArray = kUnknown;
+    GLuint m_ActiveUnit = kUnknown;
+    Unit m_Units[kTextureUnits];
+    UniformRange m_UniformBuffers[kUniformBindings];
+    GLuint m_DrawFramebuffer = kUnknown;
+    GLuint m_ReadFramebuffer = kUnknown;
+    GLint m_Viewport[4] = {(GLint) kUnknown, 0, 0, 0};
+    GLStateStats m_Stats;
+    std::set<std::string> m_ReportedDrifts;
+
+    // Counts the call and returns true when value is what the shadow holds,
+    // otherwise stores it for the caller to pass on to GL.
+    bool unchanged(GLuint& shadow, GLuint value) {
+        ++m_Stats.calls;
+        if (shadow == value) {
+            return true;
+        }
+        shadow = value;
+        return false;
+    }
+
+    bool unchanged(GLuint (&shadow)[3], const GLuint (&value)[3]) {
+        ++m_Stats.calls;
+        if (shadow[0] == value[0] && shadow[1] == value[1] && shadow[2] == value[2]) {
+            return true;
+        }
+        for (int i = 0; i < 3; i++) {
+            shadow[i] = value[i];
+        }
+        return false;
+    }
+
+    // passes redundant through, counting the calls it drops
+    bool filtered(bool redundant) {
+        if (redundant) {
+            ++m_Stats.skipped;
+        }
+        return redundant;
+    }
+
+    GLuint* textureSlot(GLuint unit, GLenum target) {
+        if (unit >= (GLuint) kTextureUnits) {
+            return nullptr;
+        }
+        if (target == GL_TEXTURE_2D) {
+            return &m_Units[unit].texture2D;
+        }
+        if (target == GL_TEXTURE_CUBE_MAP) {
+            return &m_Units[unit].cubeMap;
+        }
+        return nullptr;
+    }
+
+    // True unless Validate is set and the context disagrees with the shadow.
+    // On a drift the caller issues the call after all, which brings the
+    // context back in line.
+    bool consistent(GLenum name, GLuint expected, const char* what) {
+        if (!Validate) {
+            return true;
+        }
+        GLint actual = 0;
+        glGetIntegerv(name, &actual);
+        if ((GLuint) actual != expected) {
+            drift(what);
+            return false;
+        }
+        return true;
+    }
+
+    bool consistentCap(GLenum cap, bool expected) {
+        if (Validate && (glIsEnabled(cap) == GL_TRUE) != expected) {
+            drift("capability");
+            return false;
+        }
+        return true;
+    }
+
+    bool consistentViewport(const GLint (&expected)[4]) {
+        if (!Validate) {
+            return true;
+        }
+        GLint actual[4];
+        glGetIntegerv(GL_VIEWPORT, actual);
+        if (!std::equal(actual, actual + 4, expected)) {
+            drift("viewport");
+            return false;
+        }
+        return true;
+    }
+
+    bool consistentUniformBuffer(GLuint index, const UniformRange& expected) {
+        if (!Validate) {
+            return true;
+        }
+        GLint buffer = 0;
+        GLint64 offset = 0;
+        GLint64 size = 0;
+        glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, index, &buffer);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_START, index, &offset);
+        glGetInteger64i_v(GL_UNIFORM_BUFFER_SIZE, index, &size);
+        if ((GLuint) buffer != expected.buffer || offset != expected.offset || size != expected.size) {
+            drift("uniform buffer range");
+            return false;
+        }
+        return true;
+    }
+
+    void drift(const char* what) {
+        ++m_Stats.drifts;
+        if (m_ReportedDrifts.insert(what).second) {
+            std::cerr << "GLState: shadow " << what << " differs from the context, something bypasses GLState"
+                      << std::endl;
+        }
+    }
+};
+
+inline GLState& glState() {
+    static GLState instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_GLSTATE_H
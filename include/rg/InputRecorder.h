@@ -0,0 +1,248 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_INPUTRECORDER_H
+#define PROJECT_BASE_INPUTRECORDER_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+enum class InputEventType : uint8_t {
+    Frame = 0,
+    Key = 1,
+    CursorPos = 2,
+    Scroll = 3
+};
+
+struct InputEvent {
+    InputEventType type;
+    int key;
+    int action;
+    int mods;
+    double x;
+    double y;
+};
+
+// Camera pose at the start of a recording, so a replay starts from the same view.
+struct InputStartState {
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+    float zoom;
+};
+
+// Records the window input of a session and plays it back frame by frame.
+//
+// A recording stores, for every frame, the scene time and deltaTime the frame
+// ran with, followed by the GLFW key, cursor and scroll events that arrived
+// while it was on screen. Replaying feeds those events back through the input
+// callbacks at the same frames and forces the recorded time steps, so the camera
+// path and animations are reproduced exactly whatever the replaying machine's
+// frame rate is.
+//
+// The file is a 4 byte magic and version, the start state and then packed
+// records in host byte order:
+//   Frame:     u8 type, f32 time, f32 deltaTime
+//   Key:       u8 type, i16 key, u8 action, u8 mods
+//   CursorPos: u8 type, f64 x, f64 y
+//   Scroll:    u8 type, f64 x, f64 y
+// Positions keep full precision, rounding them would make the replayed camera drift.
+class InputRecorder {
+public:
+    static const uint32_t kMagic = 0x4e495247; // "GRIN"
+    static const uint32_t kVersion = 1;
+
+    ~InputRecorder() {
+        stop();
+    }
+
+    bool recording() const { return m_Recording; }
+    bool replaying() const { return m_Replaying; }
+
+    // Live GLFW events must not reach the program while a replay drives it.
+    bool acceptsLiveInput() const {
+        return !m_Replaying || m_Dispatching;
+    }
+
+    bool startRecording(const std::string& path, const InputStartState& start) {
+        stop();
+        m_File = std::fopen(path.c_str(), "wb");
+        if (!m_File) {
+            std::cerr << "Failed to open input recording " << path << std::endl;
+            return false;
+        }
+        write(kMagic);
+        write(kVersion);
+        write(start);
+        m_Recording = true;
+        return true;
+    }
+
+    bool startReplay(const std::string& path, InputStartState& start) {
+        stop();
+        m_File = std::fopen(path.c_str(), "rb");
+        if (!m_File) {
+            std::cerr << "Failed to open input recording " << path << std::endl;
+            return false;
+        }
+        uint32_t magic = 0, version = 0;
+        if (!read(magic) || !read(version) || magic != kMagic || version != kVersion || !read(start)) {
+            std::cerr << "Not an input recording: " << path << std::endl;
+            stop();
+            return false;
+        }
+        m_Replaying = true;
+        m_Frames = 0;
+        m_HeldKeys.clear();
+        // the events of the first frame come after its header, read it now
+        uint8_t type = 0;
+        m_PendingFrame = read(type) && type == (uint8_t) InputEventType::Frame;
+        return true;
+    }
+
+    void stop() {
+        if (m_File) {
+            std::fclose(m_File);
+            m_File = nullptr;
+        }
+        m_Recording = false;
+        m_Replaying = false;
+    }
+
+    // Call at the start of every frame. While recording, stores the frame's
+    // timing. While replaying, overwrites time and deltaTime with the recorded
+    // values and returns false once the recording has run out.
+    bool beginFrame(float& time, float& deltaTime) {
+        if (m_Recording) {
+            write(InputEventType::Frame);
+            write(time);
+            write(deltaTime);
+        } else if (m_Replaying) {
+            if (!m_PendingFrame || !read(time) || !read(deltaTime)) {
+                std::cout << "Input replay finished after " << m_Frames << " frames" << std::endl;
+                stop();
+                return false;
+            }
+            ++m_Frames;
+            readFrameEvents();
+        }
+        return true;
+    }
+
+    void recordKey(int key, int action, int mods) {
+        if (!m_Recording) {
+            return;
+        }
+        write(InputEventType::Key);
+        write((int16_t) key);
+        write((uint8_t) action);
+        write((uint8_t) mods);
+    }
+
+    void recordCursorPos(double x, double y) {
+        if (!m_Recording) {
+            return;
+        }
+        write(InputEventType::CursorPos);
+        write(x);
+        write(y);
+    }
+
+    void recordScroll(double x, double y) {
+        if (!m_Recording) {
+            return;
+        }
+        write(InputEventType::Scroll);
+        write(x);
+        write(y);
+    }
+
+    // Hands this frame's recorded events to handler(const InputEvent&), in the
+    // order they arrived. Call where glfwPollEvents() would have delivered them.
+    template<typename Handler>
+    void dispatchEvents(Handler handler) {
+        m_Dispatching = true;
+        for (const InputEvent& event : m_Events) {
+            if (event.type == InputEventType::Key) {
+                if (event.action == 0) {
+                    m_HeldKeys.erase(event.key);
+                } else {
+                    m_HeldKeys.insert(event.key);
+                }
+            }
+            handler(event);
+        }
+        m_Dispatching = false;
+        m_Events.clear();
+    }
+
+    // Replayed replacement for glfwGetKey(window, key) == GLFW_PRESS.
+    bool keyDown(int key) const {
+        return m_HeldKeys.count(key) > 0;
+    }
+
+private:
+    std::FILE* m_File = nullptr;
+    bool m_Recording = false;
+    bool m_Replaying = false;
+    bool m_Dispatching = false;
+    bool m_PendingFrame = false;
+    unsigned int m_Frames = 0;
+    std::vector<InputEvent> m_Events;
+    std::set<int> m_HeldKeys;
+
+    template<typename T>
+    void write(const T& value) {
+        std::fwrite(&value, sizeof(T), 1, m_File);
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        return std::fread(&value, sizeof(T), 1, m_File) == 1;
+    }
+
+    // Reads events up to the next frame header, which is consumed as well.
+    void readFrameEvents() {
+        m_Events.clear();
+        m_PendingFrame = false;
+        uint8_t type;
+        while (read(type)) {
+            InputEvent event = {};
+            event.type = (InputEventType) type;
+            if (event.type == InputEventType::Frame) {
+                m_PendingFrame = true;
+                return;
+            } else if (event.type == InputEventType::Key) {
+                int16_t key;
+                uint8_t action, mods;
+                if (!read(key) || !read(action) || !read(mods)) {
+                    return;
+                }
+                event.key = key;
+                event.action = action;
+                event.mods = mods;
+            } else if (event.type == InputEventType::CursorPos || event.type == InputEventType::Scroll) {
+                if (!read(event.x) || !read(event.y)) {
+                    return;
+                }
+            } else {
+                std::cerr << "Corrupt input recording, unknown event " << (int) type << std::endl;
+                return;
+            }
+            m_Events.push_back(event);
+        }
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_INPUTRECORDER_H
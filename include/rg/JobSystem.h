@@ -0,0 +1,282 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_JOBSYSTEM_H
+#define PROJECT_BASE_JOBSYSTEM_H
+
+#include <rg/Profiler.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+class JobSystem;
+
+// Number of unfinished jobs in a group. Jobs started with the counter add to
+// it, JobSystem::wait() blocks until it is back to zero and
+// JobSystem::runAfter() starts a job once it is.
+class JobCounter {
+public:
+    bool done() const {
+        return m_Pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation {
+        const char* name;
+        std::function<void()> body;
+        JobCounter* counter;
+    };
+
+    std::atomic<int> m_Pending{0};
+    std::mutex m_Mutex;
+    std::vector<Continuation> m_Continuations;
+};
+
+// Fixed pool of worker threads with one deque per worker. A worker pushes and
+// pops jobs at the back of its own deque, so related work stays on one core,
+// and steals from the front of the others' when it runs dry. Threads outside
+// the pool (main, render) submit to a shared deque that every worker steals
+// from, and run jobs themselves while they wait for a counter.
+//
+// Jobs are meant for CPU work that takes at least tens of microseconds: mesh
+// processing, texture decoding, transform updates. Each one shows up as a CPU
+// scope on its worker's track in profiler captures.
+//
+//   rg::JobCounter counter;
+//   for (size_t i = 0; i < images.size(); i++)
+//       rg::jobs().run("Decode texture", [&, i] { decode(images[i]); }, &counter);
+//   rg::jobs().wait(counter);
+//
+// With no workers (init(0), or before init()) every job runs inline.
+class JobSystem {
+public:
+    ~JobSystem() {
+        shutdown();
+    }
+
+    // workers < 0 leaves one hardware thread each for the main and the render
+    // thread.
+    void init(int workers = -1) {
+        shutdown();
+        if (workers < 0) {
+            workers = std::max(1, (int) std::thread::hardware_concurrency() - 2);
+        }
+        m_Stop = false;
+        m_WorkerCount = workers;
+        // deque 0 is the shared one for threads outside the pool
+        for (int i = 0; i <= workers; i++) {
+            m_Queues.emplace_back(new Queue());
+        }
+        for (int i = 1; i <= workers; i++) {
+            m_Threads.emplace_back([this, i] { workerMain(i); });
+        }
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_all();
+        for (std::thread& thread : m_Threads) {
+            thread.join();
+        }
+        m_Threads.clear();
+        m_Queues.clear();
+        m_WorkerCount = 0;
+    }
+
+    int workerCount() const {
+        return m_WorkerCount;
+    }
+
+    // Queues body. counter, if given, counts the job until it has finished.
+    void run(const char* name, std::function<void()> body, JobCounter* counter = nullptr) {
+        if (counter) {
+            counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        push(Job{name, std::move(body), counter});
+    }
+
+    // Queues body once dependency is done, without blocking the caller.
+    void runAfter(JobCounter& dependency, const char* name, std::function<void()> body,
+                  JobCounter* counter = nullptr) {
+        if (counter) {
+            counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+            if (!dependency.done()) {
+                dependency.m_Continuations.push_back({name, std::move(body), counter});
+                return;
+            }
+        }
+        push(Job{name, std::move(body), counter});
+    }
+
+    // Runs queued jobs until counter is done. Safe to call from inside a job.
+    // The counter may be destroyed once this returns.
+    void wait(JobCounter& counter) {
+        while (!counter.done()) {
+            if (!runOne(workerIndex())) {
+                std::this_thread::yield();
+            }
+        }
+        // the last finish() may still be unlocking the counter
+        std::lock_guard<std::mutex> lock(counter.m_Mutex);
+    }
+
+    // Calls body(i) for every i in [begin, end), grain indices per job, and
+    // waits for all of them.
+    void parallelFor(const char* name, size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t)>& body) {
+        grain = std::max<size_t>(grain, 1);
+        JobCounter counter;
+        for (size_t first = begin; first < end; first += grain) {
+            size_t last = std::min(first + grain, end);
+            run(name, [&body, first, last] {
+                for (size_t i = first; i < last; i++) {
+                    body(i);
+                }
+            }, &counter);
+        }
+        wait(counter);
+    }
+
+private:
+    struct Job {
+        const char* name;
+        std::function<void()> body;
+        JobCounter* counter;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_Queues;
+    std::vector<std::thread> m_Threads;
+    int m_WorkerCount = 0;
+    // jobs sitting in any deque, so idle workers know when to wake up
+    std::atomic<int> m_Queued{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_Wake;
+    bool m_Stop = false;
+
+    // 1..workerCount() on the pool's threads, 0 everywhere else
+    static int& workerIndex() {
+        thread_local int index = 0;
+        return index;
+    }
+
+    void push(Job job) {
+        if (m_WorkerCount == 0) {
+            execute(job);
+            return;
+        }
+        Queue& queue = *m_Queues[workerIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+        m_Queued.fetch_add(1, std::memory_order_release);
+        {
+            // pairs with the predicate check of a worker about to sleep
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+        }
+        m_Wake.notify_one();
+    }
+
+    // Takes the newest job of the own deque, else the oldest of another one.
+    bool runOne(int self) {
+        if (m_WorkerCount == 0) {
+            return false;
+        }
+        Job job;
+        bool found = false;
+        int count = (int) m_Queues.size();
+        for (int i = 0; i < count && !found; i++) {
+            Queue& queue = *m_Queues[(self + i) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.jobs.empty()) {
+                continue;
+            }
+            if (i == 0 && self != 0) {
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+            } else {
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+            }
+            found = true;
+        }
+        if (!found) {
+            return false;
+        }
+        m_Queued.fetch_sub(1, std::memory_order_relaxed);
+        execute(job);
+        return true;
+    }
+
+    void execute(Job& job) {
+        Profiler& profiler = rg::profiler();
+        profiler.beginCpuScope(job.name);
+        job.body();
+        profiler.endCpuScope();
+        if (job.counter) {
+            finish(*job.counter);
+        }
+    }
+
+    // The count drops under the counter's lock, so runAfter() cannot add a
+    // continuation after the last job has collected them.
+    void finish(JobCounter& counter) {
+        std::vector<JobCounter::Continuation> continuations;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_Mutex);
+            if (counter.m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter.m_Continuations);
+            }
+        }
+        for (JobCounter::Continuation& continuation : continuations) {
+            push(Job{continuation.name, std::move(continuation.body), continuation.counter});
+        }
+    }
+
+    void workerMain(int index) {
+        workerIndex() = index;
+        rg::profiler().setThreadName("Worker " + std::to_string(index));
+        while (true) {
+            if (runOne(index)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_Wake.wait(lock, [this] { return m_Stop || m_Queued.load(std::memory_order_acquire) > 0; });
+            if (m_Stop) {
+                return;
+            }
+        }
+    }
+};
+
+inline JobSystem& jobs() {
+    static JobSystem instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_JOBSYSTEM_H
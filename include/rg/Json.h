@@ -0,0 +1,273 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_JSON_H
+#define PROJECT_BASE_JSON_H
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Returns value as a quoted JSON string literal.
+inline std::string jsonString(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// Parsed JSON document, enough for the small config files the tools read.
+// Lookups never fail: missing members and wrong types yield the fallback.
+class JsonValue {
+public:
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    Type type() const { return m_Type; }
+    bool isNull() const { return m_Type == Null; }
+
+    bool asBool(bool fallback = false) const {
+        return m_Type == Bool ? m_Bool : fallback;
+    }
+
+    double asNumber(double fallback = 0.0) const {
+        return m_Type == Number ? m_Number : fallback;
+    }
+
+    std::string asString(const std::string& fallback = "") const {
+        return m_Type == String ? m_String : fallback;
+    }
+
+    // Number of array elements, 0 for everything else.
+    size_t size() const {
+        return m_Type == Array ? m_Array.size() : 0;
+    }
+
+    const JsonValue& operator[](size_t index) const {
+        return index < size() ? m_Array[index] : null();
+    }
+
+    const JsonValue& operator[](const std::string& key) const {
+        if (m_Type != Object) {
+            return null();
+        }
+        auto it = m_Object.find(key);
+        return it == m_Object.end() ? null() : it->second;
+    }
+
+    bool has(const std::string& key) const {
+        return m_Type == Object && m_Object.count(key) > 0;
+    }
+
+    // Parses text into out. On failure returns false and describes the problem
+    // in error.
+    static bool parse(const std::string& text, JsonValue& out, std::string& error) {
+        const char* cursor = text.c_str();
+        out = JsonValue();
+        if (!parseValue(cursor, out, error)) {
+            return false;
+        }
+        skipWhitespace(cursor);
+        if (*cursor != '\0') {
+            error = "unexpected trailing characters";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    Type m_Type = Null;
+    bool m_Bool = false;
+    double m_Number = 0.0;
+    std::string m_String;
+    std::vector<JsonValue> m_Array;
+    std::map<std::string, JsonValue> m_Object;
+
+    static const JsonValue& null() {
+        static JsonValue value;
+        return value;
+    }
+
+    static void skipWhitespace(const char*& cursor) {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r') {
+            ++cursor;
+        }
+    }
+
+    static bool parseString(const char*& cursor, std::string& out, std::string& error) {
+        // cursor is on the opening quote
+        ++cursor;
+        out.clear();
+        while (*cursor != '"') {
+            if (*cursor == '\0') {
+                error = "unterminated string";
+                return false;
+            }
+            if (*cursor == '\\') {
+                ++cursor;
+                switch (*cursor) {
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': {
+                        // only the ASCII range is supported, which is all paths need
+                        for (int i = 1; i <= 4; i++) {
+                            if (!std::isxdigit((unsigned char) cursor[i])) {
+                                error = "invalid \\u escape";
+                                return false;
+                            }
+                        }
+                        std::string hex(cursor + 1, 4);
+                        out += (char) std::strtol(hex.c_str(), nullptr, 16);
+                        cursor += 4;
+                        break;
+                    }
+                    case '\0':
+                        error = "unterminated string";
+                        return false;
+                    default: out += *cursor; break;
+                }
+                ++cursor;
+            } else {
+                out += *cursor++;
+            }
+        }
+        ++cursor;
+        return true;
+    }
+
+    static bool parseLiteral(const char*& cursor, const char* literal) {
+        size_t length = std::char_traits<char>::length(literal);
+        // strncmp stops at the end of the text
+        if (std::strncmp(cursor, literal, length) != 0) {
+            return false;
+        }
+        cursor += length;
+        return true;
+    }
+
+    static bool parseValue(const char*& cursor, JsonValue& out, std::string& error) {
+        skipWhitespace(cursor);
+        switch (*cursor) {
+            case '{': {
+                out.m_Type = Object;
+                ++cursor;
+                skipWhitespace(cursor);
+                if (*cursor == '}') {
+                    ++cursor;
+                    return true;
+                }
+                while (true) {
+                    skipWhitespace(cursor);
+                    std::string key;
+                    if (*cursor != '"' || !parseString(cursor, key, error)) {
+                        if (error.empty()) {
+                            error = "expected member name";
+                        }
+                        return false;
+                    }
+                    skipWhitespace(cursor);
+                    if (*cursor++ != ':') {
+                        error = "expected ':' after \"" + key + "\"";
+                        return false;
+                    }
+                    if (!parseValue(cursor, out.m_Object[key], error)) {
+                        return false;
+                    }
+                    skipWhitespace(cursor);
+                    if (*cursor == ',') {
+                        ++cursor;
+                    } else if (*cursor == '}') {
+                        ++cursor;
+                        return true;
+                    } else {
+                        error = "expected ',' or '}'";
+                        return false;
+                    }
+                }
+            }
+            case '[': {
+                out.m_Type = Array;
+                ++cursor;
+                skipWhitespace(cursor);
+                if (*cursor == ']') {
+                    ++cursor;
+                    return true;
+                }
+                while (true) {
+                    out.m_Array.emplace_back();
+                    if (!parseValue(cursor, out.m_Array.back(), error)) {
+                        return false;
+                    }
+                    skipWhitespace(cursor);
+                    if (*cursor == ',') {
+                        ++cursor;
+                    } else if (*cursor == ']') {
+                        ++cursor;
+                        return true;
+                    } else {
+                        error = "expected ',' or ']'";
+                        return false;
+                    }
+                }
+            }
+            case '"':
+                out.m_Type = String;
+                return parseString(cursor, out.m_String, error);
+            case 't':
+            case 'f':
+                out.m_Type = Bool;
+                out.m_Bool = *cursor == 't';
+                if (!parseLiteral(cursor, out.m_Bool ? "true" : "false")) {
+                    error = "invalid literal";
+                    return false;
+                }
+                return true;
+            case 'n':
+                if (!parseLiteral(cursor, "null")) {
+                    error = "invalid literal";
+                    return false;
+                }
+                return true;
+            default: {
+                char* end = nullptr;
+                out.m_Number = std::strtod(cursor, &end);
+                if (end == cursor) {
+                    error = *cursor == '\0' ? "unexpected end of input" : "unexpected character";
+                    return false;
+                }
+                out.m_Type = Number;
+                cursor = end;
+                return true;
+            }
+        }
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_JSON_H
@@ -0,0 +1,249 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_MATERIAL_H
+#define PROJECT_BASE_MATERIAL_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <rg/Align.h>
+#include <rg/CommandList.h>
+#include <rg/GLState.h>
+#include <rg/MemoryTracker.h>
+#include <rg/ShaderCache.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rg {
+
+// Parameters of a material, laid out as the std140 MaterialParams block in
+// blinn_phong.glsl. The colours stand in for maps the material does not have.
+struct MaterialParams {
+    glm::vec3 Diffuse = glm::vec3(0.64f);
+    float Shininess = 32.0f;
+    glm::vec3 Specular = glm::vec3(0.5f);
+    float Padding = 0.0f;
+};
+
+static_assert(sizeof(MaterialParams) == 32, "MaterialParams has to match the std140 block");
+
+// What a material is made of. Two materials with the same content are the
+// same material.
+struct MaterialDesc {
+    GLuint DiffuseMap = 0;
+    GLuint SpecularMap = 0;
+    GLuint NormalMap = 0;
+    MaterialParams Params;
+
+    bool operator==(const MaterialDesc& other) const {
+        return std::memcmp(this, &other, sizeof(MaterialDesc)) == 0;
+    }
+};
+
+// compared and hashed bytewise, so there must not be any padding
+static_assert(sizeof(MaterialDesc) == 3 * sizeof(GLuint) + sizeof(MaterialParams), "MaterialDesc has padding");
+
+class MaterialLibrary;
+
+// A shader permutation, a parameter block and a set of maps. Materials live in
+// a MaterialLibrary, which hands out one object per distinct content, so
+// meshes with identical materials share their GPU state: consecutive draws
+// record the same binds and GLState drops them on replay.
+class Material {
+public:
+    // binding point of the MaterialParams block
+    static const GLuint kBlockBinding = 1;
+    // texture units of the maps; shaders point their samplers at them once
+    static const GLuint kDiffuseUnit = 0;
+    static const GLuint kSpecularUnit = 1;
+    static const GLuint kNormalUnit = 2;
+
+    const MaterialDesc& desc() const {
+        return m_Desc;
+    }
+
+    // the ShaderFeature bits of the maps the material has
+    unsigned int features() const {
+        unsigned int features = 0;
+        if (m_Desc.DiffuseMap) {
+            features |= HAS_DIFFUSE_MAP;
+        }
+        if (m_Desc.SpecularMap) {
+            features |= HAS_SPECULAR_MAP;
+        }
+        if (m_Desc.NormalMap) {
+            features |= HAS_NORMAL_MAP;
+        }
+        return features;
+    }
+
+    // Binds the maps and the parameter block, for the program of the last
+    // list.use().
+    void record(CommandList& list) const;
+
+private:
+    friend class MaterialLibrary;
+
+    MaterialDesc m_Desc;
+    // index of the parameter block in the library's uniform buffer
+    size_t m_Slot = 0;
+    const MaterialLibrary* m_Library = nullptr;
+};
+
+// Owns every material and one uniform buffer with the parameter blocks of all
+// of them. get() deduplicates by content hash. Parameters are uploaded by
+// upload() and only when they changed, which for the materials of loaded
+// models is once.
+//
+// get() and setParams() are not synchronised; they are meant for model
+// loading and for the GL thread in between frames.
+class MaterialLibrary {
+public:
+    // the material with desc's content, created on first use
+    const Material* get(const MaterialDesc& desc) {
+        std::vector<Material*>& bucket = m_Buckets[hash(desc)];
+        for (Material* material : bucket) {
+            if (material->m_Desc == desc) {
+                return material;
+            }
+        }
+        std::unique_ptr<Material> material(new Material());
+        material->m_Desc = desc;
+        material->m_Slot = m_Materials.size();
+        material->m_Library = this;
+        markDirty(material->m_Slot);
+        bucket.push_back(material.get());
+        m_Materials.push_back(std::move(material));
+        return m_Materials.back().get();
+    }
+
+    // Changes the parameters of material, and with it of every mesh using it.
+    // A material that ends up equal to another one stays a separate object.
+    void setParams(const Material* material, const MaterialParams& params) {
+        Material* changed = m_Materials[material->m_Slot].get();
+        std::vector<Material*>& bucket = m_Buckets[hash(changed->m_Desc)];
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), changed), bucket.end());
+        changed->m_Desc.Params = params;
+        m_Buckets[hash(changed->m_Desc)].push_back(changed);
+        markDirty(changed->m_Slot);
+    }
+
+    // GL thread: uploads the parameter blocks that changed since the last
+    // call, growing the buffer first if materials were added.
+    void upload() {
+        if (m_DirtyBegin >= m_DirtyEnd) {
+            return;
+        }
+        if (m_Stride == 0) {
+            GLint alignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            m_Stride = alignUp<GLsizeiptr>(sizeof(MaterialParams), std::max<GLint>(alignment, 16));
+        }
+        if (m_Capacity < m_Materials.size()) {
+            size_t capacity = std::max<size_t>(m_Materials.size(), 2 * m_Capacity);
+            destroy();
+            m_Capacity = capacity;
+            glGenBuffers(1, &m_Buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, m_Capacity * m_Stride, nullptr, GL_STATIC_DRAW);
+            memoryTracker().bufferAllocated(m_Buffer, m_Capacity * m_Stride, GL_STATIC_DRAW, MemoryCategory::Uniform,
+                                            "Materials");
+            m_DirtyBegin = 0;
+            m_DirtyEnd = m_Materials.size();
+        } else {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+        }
+        std::vector<char> blocks((m_DirtyEnd - m_DirtyBegin) * m_Stride);
+        for (size_t i = m_DirtyBegin; i < m_DirtyEnd; i++) {
+            std::memcpy(&blocks[(i - m_DirtyBegin) * m_Stride], &m_Materials[i]->m_Desc.Params, sizeof(MaterialParams));
+        }
+        glBufferSubData(GL_COPY_WRITE_BUFFER, m_DirtyBegin * m_Stride, blocks.size(), blocks.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        m_DirtyBegin = m_DirtyEnd = 0;
+    }
+
+    GLuint buffer() const {
+        return m_Buffer;
+    }
+
+    GLsizeiptr stride() const {
+        return m_Stride;
+    }
+
+    size_t size() const {
+        return m_Materials.size();
+    }
+
+    // Frees the uniform buffer; the materials stay and are uploaded again by
+    // the next upload().
+    void destroy() {
+        if (m_Buffer) {
+            glDeleteBuffers(1, &m_Buffer);
+            glState().bufferDeleted(m_Buffer);
+            memoryTracker().bufferDeleted(m_Buffer);
+            m_Buffer = 0;
+        }
+        m_Capacity = 0;
+        if (!m_Materials.empty()) {
+            m_DirtyBegin = 0;
+            m_DirtyEnd = m_Materials.size();
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Material>> m_Materials;
+    std::unordered_map<size_t, std::vector<Material*>> m_Buckets;
+    GLuint m_Buffer = 0;
+    size_t m_Capacity = 0;
+    GLsizeiptr m_Stride = 0;
+    // slots [begin, end) hold parameters the buffer does not have yet
+    size_t m_DirtyBegin = 0;
+    size_t m_DirtyEnd = 0;
+
+    void markDirty(size_t slot) {
+        if (m_DirtyBegin >= m_DirtyEnd) {
+            m_DirtyBegin = slot;
+            m_DirtyEnd = slot + 1;
+        } else {
+            m_DirtyBegin = std::min(m_DirtyBegin, slot);
+            m_DirtyEnd = std::max(m_DirtyEnd, slot + 1);
+        }
+    }
+
+    // FNV-1a over the content
+    static size_t hash(const MaterialDesc& desc) {
+        const unsigned char* bytes = (const unsigned char*) &desc;
+        uint64_t value = 14695981039346656037ull;
+        for (size_t i = 0; i < sizeof(MaterialDesc); i++) {
+            value = (value ^ bytes[i]) * 1099511628211ull;
+        }
+        return (size_t) value;
+    }
+};
+
+inline void Material::record(CommandList& list) const {
+    if (m_Desc.DiffuseMap) {
+        list.bindTexture(kDiffuseUnit, GL_TEXTURE_2D, m_Desc.DiffuseMap);
+    }
+    if (m_Desc.SpecularMap) {
+        list.bindTexture(kSpecularUnit, GL_TEXTURE_2D, m_Desc.SpecularMap);
+    }
+    if (m_Desc.NormalMap) {
+        list.bindTexture(kNormalUnit, GL_TEXTURE_2D, m_Desc.NormalMap);
+    }
+    list.bindUniformBuffer(kBlockBinding, m_Library->buffer(), m_Slot * m_Library->stride(), sizeof(MaterialParams));
+}
+
+inline MaterialLibrary& materials() {
+    static MaterialLibrary instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_MATERIAL_H
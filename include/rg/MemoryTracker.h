@@ -0,0 +1,433 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_MEMORYTRACKER_H
+#define PROJECT_BASE_MEMORYTRACKER_H
+
+#include <glad/glad.h>
+#include <rg/Json.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rg {
+
+enum class MemoryCategory : int {
+    // vertex and index buffers
+    Geometry,
+    // textures of models and the skybox
+    Texture,
+    // attachments of offscreen framebuffers
+    RenderTarget,
+    // uniform buffers: material parameters, per-frame data
+    Uniform,
+    // pixel unpack buffers of texture uploads
+    Staging,
+    // CPU copies of mesh data
+    CpuGeometry,
+    // the mapped asset package
+    AssetPackage,
+    Count
+};
+
+inline const char* memoryCategoryName(MemoryCategory category) {
+    static const char* names[(int) MemoryCategory::Count] = {
+        "Geometry", "Texture", "Render target", "Uniform", "Staging", "CPU geometry", "Asset package"};
+    return names[(int) category];
+}
+
+inline bool isGpuCategory(MemoryCategory category) {
+    return category < MemoryCategory::CpuGeometry;
+}
+
+enum class MemoryResource : int {
+    Buffer,
+    Texture,
+    Renderbuffer,
+    // CPU memory, identified by the address of its owner object
+    Cpu,
+};
+
+inline const char* memoryResourceName(MemoryResource resource) {
+    static const char* names[] = {"buffer", "texture", "renderbuffer", "cpu"};
+    return names[(int) resource];
+}
+
+// one tracked object and everything it holds
+struct MemoryAllocation {
+    MemoryResource Resource = MemoryResource::Buffer;
+    // GL name, or the owner's address for CPU memory
+    uint64_t Id = 0;
+    size_t Bytes = 0;
+    // internal format of images, usage of buffers
+    GLenum Format = 0;
+    MemoryCategory Category = MemoryCategory::Geometry;
+    std::string Owner;
+};
+
+namespace memory_detail {
+
+inline std::string& currentOwner() {
+    thread_local std::string owner;
+    return owner;
+}
+
+};
+
+// Names the owner of everything allocated on this thread while it lives,
+// e.g. the model being loaded. Scopes nest.
+class MemoryOwnerScope {
+public:
+    explicit MemoryOwnerScope(std::string owner) : m_Previous(std::move(memory_detail::currentOwner())) {
+        memory_detail::currentOwner() = std::move(owner);
+    }
+
+    ~MemoryOwnerScope() {
+        memory_detail::currentOwner() = std::move(m_Previous);
+    }
+
+    MemoryOwnerScope(const MemoryOwnerScope&) = delete;
+    MemoryOwnerScope& operator=(const MemoryOwnerScope&) = delete;
+
+private:
+    std::string m_Previous;
+};
+
+// Bytes held by every buffer, texture and renderbuffer the application
+// creates, and by the larger CPU-side copies, with format, category and
+// owner. The code that allocates reports here right after the GL call and
+// again after deleting, the same way it tells GLState about deletions.
+// Texture images are tracked per level and cube face, so partially resident
+// textures (TextureStreamer) count what they hold.
+//
+// Sizes of uncompressed images are what drivers commonly allocate, RGB
+// formats padded to four components; the driver's own overhead is not
+// visible to GL 3.3 and not included.
+//
+// Thread safe. Owners default to the innermost MemoryOwnerScope of the
+// calling thread.
+//
+//   glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+//   rg::memoryTracker().bufferAllocated(vbo, size, GL_STATIC_DRAW, rg::MemoryCategory::Geometry);
+//   ...
+//   glDeleteBuffers(1, &vbo);
+//   rg::memoryTracker().bufferDeleted(vbo);
+class MemoryTracker {
+public:
+    // Bytes of one image of internalFormat, for the formats this application
+    // uses; unknown formats count four bytes per pixel.
+    static size_t imageBytes(GLenum internalFormat, int width, int height, int samples = 1) {
+        size_t pixel = 4;
+        switch (internalFormat) {
+            case GL_RED:
+            case GL_R8:
+                pixel = 1;
+                break;
+            case GL_RG:
+            case GL_RG8:
+            case GL_R16F:
+                pixel = 2;
+                break;
+            case GL_RGB16F:
+            case GL_RGBA16F:
+            case GL_RG32F:
+                pixel = 8;
+                break;
+            case GL_RGB32F:
+            case GL_RGBA32F:
+                pixel = 16;
+                break;
+            default:
+                break;
+        }
+        return pixel * (size_t) width * (size_t) height * (size_t) std::max(samples, 1);
+    }
+
+    // a short name of a format or buffer usage, for reports
+    static std::string formatName(GLenum format) {
+        switch (format) {
+            case 0: return "-";
+            case GL_RED: return "RED";
+            case GL_RG: return "RG";
+            case GL_RGB: return "RGB";
+            case GL_RGBA: return "RGBA";
+            case GL_R8: return "R8";
+            case GL_RG8: return "RG8";
+            case GL_RGB8: return "RGB8";
+            case GL_RGBA8: return "RGBA8";
+            case GL_SRGB: return "SRGB";
+            case GL_SRGB8: return "SRGB8";
+            case GL_SRGB8_ALPHA8: return "SRGB8_ALPHA8";
+            case GL_R16F: return "R16F";
+            case GL_RG16F: return "RG16F";
+            case GL_RGB16F: return "RGB16F";
+            case GL_RGBA16F: return "RGBA16F";
+            case GL_RG32F: return "RG32F";
+            case GL_RGBA32F: return "RGBA32F";
+            case GL_DEPTH24_STENCIL8: return "DEPTH24_STENCIL8";
+            case 0x83F0: return "BC1";
+            case 0x83F3: return "BC3";
+            case GL_STATIC_DRAW: return "STATIC_DRAW";
+            case GL_DYNAMIC_DRAW: return "DYNAMIC_DRAW";
+            case GL_STREAM_DRAW: return "STREAM_DRAW";
+            default: {
+                char text[16];
+                std::snprintf(text, sizeof(text), "0x%04X", format);
+                return text;
+            }
+        }
+    }
+
+    // Records the data store of buffer id, replacing what it had.
+    void bufferAllocated(GLuint id, size_t bytes, GLenum usage, MemoryCategory category, const char* owner = nullptr) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Entry& entry = m_Entries[{MemoryResource::Buffer, id}];
+        describe(entry, MemoryResource::Buffer, id, usage, category, owner);
+        entry.Allocation.Bytes = bytes;
+    }
+
+    void bufferDeleted(GLuint id) {
+        forget(MemoryResource::Buffer, id);
+    }
+
+    // Records level of target (GL_TEXTURE_2D or a cube map face) of texture
+    // id. bytes is the size of compressed images; 0 computes it from the
+    // format.
+    void textureLevelAllocated(GLuint id, GLenum target, GLint level, GLenum internalFormat, int width, int height,
+                               size_t bytes, MemoryCategory category, const char* owner = nullptr) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Entry& entry = m_Entries[{MemoryResource::Texture, id}];
+        describe(entry, MemoryResource::Texture, id, internalFormat, category, owner);
+        Image& image = entry.Images[imageKey(target, level)];
+        image.Width = width;
+        image.Height = height;
+        image.Bytes = bytes ? bytes : imageBytes(internalFormat, width, height);
+        entry.total();
+    }
+
+    // A level that was respecified empty, see TextureStreamer.
+    void textureLevelReleased(GLuint id, GLenum target, GLint level) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto found = m_Entries.find({MemoryResource::Texture, id});
+        if (found != m_Entries.end()) {
+            found->second.Images.erase(imageKey(target, level));
+            found->second.total();
+        }
+    }
+
+    // After glGenerateMipmap: the levels below each base image.
+    void textureMipmapsGenerated(GLuint id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto found = m_Entries.find({MemoryResource::Texture, id});
+        if (found == m_Entries.end()) {
+            return;
+        }
+        Entry& entry = found->second;
+        std::map<int, Image> bases = entry.Images;
+        for (const auto& base : bases) {
+            if (base.first % kMaxLevels != 0) {
+                continue;
+            }
+            int width = base.second.Width, height = base.second.Height;
+            for (int level = 1; (width > 1 || height > 1) && level < kMaxLevels; level++) {
+                width = std::max(width / 2, 1);
+                height = std::max(height / 2, 1);
+                Image& image = entry.Images[base.first + level];
+                image.Width = width;
+                image.Height = height;
+                image.Bytes = imageBytes(entry.Allocation.Format, width, height);
+            }
+        }
+        entry.total();
+    }
+
+    void textureDeleted(GLuint id) {
+        forget(MemoryResource::Texture, id);
+    }
+
+    void renderbufferAllocated(GLuint id, GLenum internalFormat, int width, int height, int samples,
+                               MemoryCategory category, const char* owner = nullptr) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Entry& entry = m_Entries[{MemoryResource::Renderbuffer, id}];
+        describe(entry, MemoryResource::Renderbuffer, id, internalFormat, category, owner);
+        entry.Allocation.Bytes = imageBytes(internalFormat, width, height, samples);
+    }
+
+    void renderbufferDeleted(GLuint id) {
+        forget(MemoryResource::Renderbuffer, id);
+    }
+
+    // CPU memory held by key, replacing what it held before.
+    void cpuAllocated(const void* key, size_t bytes, MemoryCategory category, const char* owner = nullptr) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        Entry& entry = m_Entries[{MemoryResource::Cpu, (uint64_t) (uintptr_t) key}];
+        describe(entry, MemoryResource::Cpu, (uint64_t) (uintptr_t) key, 0, category, owner);
+        entry.Allocation.Bytes = bytes;
+    }
+
+    void cpuFreed(const void* key) {
+        forget(MemoryResource::Cpu, (uint64_t) (uintptr_t) key);
+    }
+
+    // bytes per category, indexed by MemoryCategory
+    std::vector<size_t> totals() const {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        std::vector<size_t> totals((int) MemoryCategory::Count, 0);
+        for (const auto& entry : m_Entries) {
+            totals[(int) entry.second.Allocation.Category] += entry.second.Allocation.Bytes;
+        }
+        return totals;
+    }
+
+    // every allocation, largest first
+    std::vector<MemoryAllocation> allocations() const {
+        std::vector<MemoryAllocation> all;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            all.reserve(m_Entries.size());
+            for (const auto& entry : m_Entries) {
+                all.push_back(entry.second.Allocation);
+            }
+        }
+        std::stable_sort(all.begin(), all.end(), [](const MemoryAllocation& a, const MemoryAllocation& b) {
+            return a.Bytes > b.Bytes;
+        });
+        return all;
+    }
+
+    // the count largest allocations
+    std::vector<MemoryAllocation> top(size_t count) const {
+        std::vector<MemoryAllocation> all = allocations();
+        all.resize(std::min(count, all.size()));
+        return all;
+    }
+
+    // bytes per owner, largest first
+    std::vector<std::pair<std::string, size_t>> owners() const {
+        std::map<std::string, size_t> byOwner;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (const auto& entry : m_Entries) {
+                byOwner[entry.second.Allocation.Owner] += entry.second.Allocation.Bytes;
+            }
+        }
+        std::vector<std::pair<std::string, size_t>> sorted(byOwner.begin(), byOwner.end());
+        std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, size_t>& a,
+                                                          const std::pair<std::string, size_t>& b) {
+            return a.second > b.second;
+        });
+        return sorted;
+    }
+
+    // Writes the totals and every allocation as JSON; false when the file
+    // cannot be written.
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            std::cerr << "MemoryTracker: cannot write " << path << '\n';
+            return false;
+        }
+        std::vector<size_t> byCategory = totals();
+        out << "{\n  \"totals\": {";
+        for (int i = 0; i < (int) MemoryCategory::Count; i++) {
+            out << (i == 0 ? "" : ", ") << jsonString(memoryCategoryName((MemoryCategory) i)) << ": " << byCategory[i];
+        }
+        out << "},\n  \"allocations\": [";
+        std::vector<MemoryAllocation> all = allocations();
+        for (size_t i = 0; i < all.size(); i++) {
+            const MemoryAllocation& a = all[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"resource\": \"" << memoryResourceName(a.Resource)
+                << "\", \"id\": " << (a.Resource == MemoryResource::Cpu ? 0 : a.Id) << ", \"bytes\": " << a.Bytes
+                << ", \"format\": " << jsonString(formatName(a.Format)) << ", \"category\": "
+                << jsonString(memoryCategoryName(a.Category)) << ", \"owner\": " << jsonString(a.Owner) << "}";
+        }
+        out << "\n  ]\n}\n";
+        return (bool) out;
+    }
+
+    // Prints every allocation still tracked, for shutdown once everything
+    // has been released. Returns how many there were.
+    size_t reportLeaks() const {
+        std::vector<MemoryAllocation> all = allocations();
+        size_t bytes = 0;
+        for (const MemoryAllocation& a : all) {
+            bytes += a.Bytes;
+            std::cout << "Leaked " << memoryResourceName(a.Resource);
+            if (a.Resource != MemoryResource::Cpu) {
+                std::cout << ' ' << a.Id;
+            }
+            std::cout << ": " << a.Bytes << " bytes, " << memoryCategoryName(a.Category) << ", "
+                      << formatName(a.Format) << ", " << (a.Owner.empty() ? "no owner" : a.Owner) << '\n';
+        }
+        if (!all.empty()) {
+            std::cout << all.size() << " allocations (" << bytes << " bytes) were not released\n";
+        }
+        return all.size();
+    }
+
+private:
+    // images of a texture are keyed face * kMaxLevels + level
+    static const int kMaxLevels = 32;
+
+    struct Image {
+        int Width = 0;
+        int Height = 0;
+        size_t Bytes = 0;
+    };
+
+    struct Entry {
+        MemoryAllocation Allocation;
+        std::map<int, Image> Images;
+
+        void total() {
+            Allocation.Bytes = 0;
+            for (const auto& image : Images) {
+                Allocation.Bytes += image.second.Bytes;
+            }
+        }
+    };
+
+    mutable std::mutex m_Mutex;
+    std::map<std::pair<MemoryResource, uint64_t>, Entry> m_Entries;
+
+    static int imageKey(GLenum target, GLint level) {
+        int face = 0;
+        if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+            face = target - GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+        }
+        return face * kMaxLevels + level;
+    }
+
+    static void describe(Entry& entry, MemoryResource resource, uint64_t id, GLenum format, MemoryCategory category,
+                         const char* owner) {
+        MemoryAllocation& a = entry.Allocation;
+        a.Resource = resource;
+        a.Id = id;
+        a.Format = format;
+        a.Category = category;
+        a.Owner = owner ? owner : memory_detail::currentOwner();
+    }
+
+    void forget(MemoryResource resource, uint64_t id) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Entries.erase({resource, id});
+    }
+};
+
+inline MemoryTracker& memoryTracker() {
+    static MemoryTracker instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_MEMORYTRACKER_H
@@ -0,0 +1,194 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_MICROBENCH_H
+#define PROJECT_BASE_MICROBENCH_H
+
+#include <rg/Json.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Passed to every benchmark body, which times its loop the same way Google
+// Benchmark does:
+//
+//   suite.add("readFileContents/building.vs", [](rg::BenchState& state) {
+//       while (state.keepRunning()) {
+//           std::string source = readFileContents("resources/shaders/building.vs");
+//           state.addBytes(source.size());
+//       }
+//   });
+//
+// Each pass of the loop is one sample. Setup before the loop is not timed, and
+// pauseTiming()/resumeTiming() exclude per-iteration cleanup.
+class BenchState {
+public:
+    BenchState(double minSeconds, int minIterations)
+        : m_MinSeconds(minSeconds), m_MinIterations(minIterations) {
+    }
+
+    bool keepRunning() {
+        auto now = std::chrono::steady_clock::now();
+        if (m_Running) {
+            m_Samples.push_back(m_SampleNs + elapsedNs(m_SampleStart, now));
+            m_TotalNs += m_Samples.back();
+        }
+        m_Running = true;
+        bool more = m_Skipped.empty() && ((int) m_Samples.size() < m_MinIterations || m_TotalNs < m_MinSeconds * 1e9);
+        m_SampleNs = 0.0;
+        m_SampleStart = std::chrono::steady_clock::now();
+        return more;
+    }
+
+    void pauseTiming() {
+        m_SampleNs += elapsedNs(m_SampleStart, std::chrono::steady_clock::now());
+    }
+
+    void resumeTiming() {
+        m_SampleStart = std::chrono::steady_clock::now();
+    }
+
+    // Work done by the current iteration, reported as throughput. name is the
+    // unit items are counted in, e.g. "vertices".
+    void addItems(double items, const char* name = "items") {
+        m_Items += items;
+        m_ItemName = name;
+    }
+    void addBytes(double bytes) { m_Bytes += bytes; }
+
+    // Marks the benchmark as not runnable here, e.g. because an asset is missing.
+    void skip(const std::string& reason) { m_Skipped = reason; }
+
+private:
+    friend class MicroBench;
+
+    double m_MinSeconds;
+    int m_MinIterations;
+    bool m_Running = false;
+    std::chrono::steady_clock::time_point m_SampleStart;
+    double m_SampleNs = 0.0;
+    double m_TotalNs = 0.0;
+    std::vector<double> m_Samples;
+    double m_Items = 0.0;
+    std::string m_ItemName;
+    double m_Bytes = 0.0;
+    std::string m_Skipped;
+
+    static double elapsedNs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration<double, std::nano>(to - from).count();
+    }
+};
+
+// Minimal benchmark runner: median time per iteration plus item and byte
+// throughput, printed as a table and optionally written as JSON so runs before
+// and after a change can be diffed.
+class MicroBench {
+public:
+    double MinSeconds = 0.5;
+    int MinIterations = 3;
+
+    void add(const std::string& name, std::function<void(BenchState&)> body) {
+        m_Benchmarks.push_back({name, body});
+    }
+
+    // Runs every benchmark whose name contains filter.
+    void run(const std::string& filter = "") {
+        std::printf("%-48s %12s %8s %12s %24s\n", "Benchmark", "Median", "Iters", "MB/s", "Items/s");
+        for (const Benchmark& benchmark : m_Benchmarks) {
+            if (benchmark.name.find(filter) == std::string::npos) {
+                continue;
+            }
+            BenchState state(MinSeconds, MinIterations);
+            benchmark.body(state);
+
+            Result result;
+            result.name = benchmark.name;
+            result.skipped = state.m_Skipped;
+            if (result.skipped.empty() && !state.m_Samples.empty()) {
+                std::vector<double> samples = state.m_Samples;
+                std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+                result.iterations = (int) samples.size();
+                result.medianNs = samples[samples.size() / 2];
+                double seconds = state.m_TotalNs / 1e9;
+                result.itemName = state.m_ItemName;
+                result.itemsPerSecond = state.m_Items / seconds;
+                result.megabytesPerSecond = state.m_Bytes / seconds / (1024.0 * 1024.0);
+            }
+            print(result);
+            m_Results.push_back(result);
+        }
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) {
+            return false;
+        }
+        out << "{\"benchmarks\": [";
+        for (size_t i = 0; i < m_Results.size(); i++) {
+            const Result& result = m_Results[i];
+            out << (i == 0 ? "\n" : ",\n") << "  {\"name\": " << jsonString(result.name);
+            if (!result.skipped.empty()) {
+                out << ", \"skipped\": " << jsonString(result.skipped) << "}";
+                continue;
+            }
+            out << ", \"iterations\": " << result.iterations << ", \"medianNs\": " << result.medianNs
+                << ", \"megabytesPerSecond\": " << result.megabytesPerSecond;
+            if (!result.itemName.empty()) {
+                out << ", " << jsonString(result.itemName + "PerSecond") << ": " << result.itemsPerSecond;
+            }
+            out << "}";
+        }
+        out << "\n]}\n";
+        return true;
+    }
+
+private:
+    struct Benchmark {
+        std::string name;
+        std::function<void(BenchState&)> body;
+    };
+
+    struct Result {
+        std::string name;
+        std::string skipped;
+        int iterations = 0;
+        double medianNs = 0.0;
+        std::string itemName;
+        double itemsPerSecond = 0.0;
+        double megabytesPerSecond = 0.0;
+    };
+
+    std::vector<Benchmark> m_Benchmarks;
+    std::vector<Result> m_Results;
+
+    static void print(const Result& result) {
+        if (!result.skipped.empty()) {
+            std::printf("%-48s skipped: %s\n", result.name.c_str(), result.skipped.c_str());
+            return;
+        }
+        char median[32];
+        if (result.medianNs >= 1e6) {
+            std::snprintf(median, sizeof(median), "%.2f ms", result.medianNs / 1e6);
+        } else {
+            std::snprintf(median, sizeof(median), "%.2f us", result.medianNs / 1e3);
+        }
+        char items[48] = "";
+        if (!result.itemName.empty()) {
+            std::snprintf(items, sizeof(items), "%.3g %s", result.itemsPerSecond, result.itemName.c_str());
+        }
+        std::printf("%-48s %12s %8d %12.1f %24s\n", result.name.c_str(), median, result.iterations,
+                    result.megabytesPerSecond, items);
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_MICROBENCH_H
@@ -0,0 +1,373 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_PAK_H
+#define PROJECT_BASE_PAK_H
+
+#include <rg/Align.h>
+#include <rg/MemoryTracker.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RG_PAK_MMAP 1
+#endif
+
+namespace rg {
+
+// what a blob holds, see CookedAssets.h for the layouts
+enum class PakBlobType : uint32_t {
+    Model = 1,
+    Texture = 2,
+};
+
+// On-disk layout, little endian:
+//   PakHeader
+//   PakEntry[EntryCount]      sorted by NameHash
+//   names                     NUL terminated, for tools and messages
+//   blobs                     each at a multiple of kPakAlignment, in the
+//                             order they were added
+struct PakHeader {
+    char Magic[4];
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint32_t NamesSize;
+    uint64_t NamesOffset;
+    uint64_t FileSize;
+};
+
+struct PakEntry {
+    uint64_t NameHash;
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t NameOffset;
+    PakBlobType Type;
+};
+
+static_assert(sizeof(PakHeader) == 32 && sizeof(PakEntry) == 32, "pak structures are written as they are");
+
+static const char kPakMagic[4] = {'R', 'G', 'P', 'K'};
+static const uint32_t kPakVersion = 1;
+// blobs start aligned for any typed access into them
+static const uint64_t kPakAlignment = 64;
+
+// FNV-1a of a resource path as the loose-file code spells it,
+// e.g. "resources/objects/cobra/Shelby.obj"
+inline uint64_t pakNameHash(const std::string& name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// A blob inside an open PakFile; data stays valid until the file is closed.
+struct PakBlob {
+    const unsigned char* Data = nullptr;
+    size_t Size = 0;
+    PakBlobType Type = PakBlobType(0);
+    const char* Name = "";
+
+    explicit operator bool() const {
+        return Data != nullptr;
+    }
+};
+
+// A package of cooked assets opened with a single mapping. Lookups return
+// pointers into the mapping, so loaders hand blob contents straight to GL
+// (glBufferData, pixel unpack buffers) without reading them into buffers of
+// their own. Blobs sit in the order the cooker wrote them, which is the order
+// the application loads them in; open() asks the kernel to read the whole file
+// ahead, so a cold start is one sequential read instead of a seek per file.
+//
+// Where mmap is not available the file is read into memory instead.
+// find() is const and may be called from any thread.
+//
+//   rg::pak().open("resources/assets.pak");
+//   if (rg::PakBlob blob = rg::pak().find("resources/objects/cobra/Shelby.obj")) ...
+class PakFile {
+public:
+    PakFile() = default;
+    PakFile(const PakFile&) = delete;
+    PakFile& operator=(const PakFile&) = delete;
+
+    ~PakFile() {
+        close();
+    }
+
+    // False when there is no such file or it is not a valid package, in which
+    // case every find() misses.
+    bool open(const std::string& path) {
+        close();
+#ifdef RG_PAK_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                m_Data = (const unsigned char*) mapping;
+                m_Size = info.st_size;
+                madvise(mapping, m_Size, MADV_WILLNEED);
+            }
+        }
+        ::close(fd);
+#else
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        std::fseek(file, 0, SEEK_END);
+        long size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        if (size > 0) {
+            m_Copy.resize(size);
+            if (std::fread(m_Copy.data(), 1, size, file) == (size_t) size) {
+                m_Data = m_Copy.data();
+                m_Size = size;
+            }
+        }
+        std::fclose(file);
+#endif
+        if (!m_Data || !validate()) {
+            std::cerr << "PakFile: " << path << " is not a valid asset package\n";
+            close();
+            return false;
+        }
+        m_Path = path;
+        memoryTracker().cpuAllocated(this, m_Size, MemoryCategory::AssetPackage, m_Path.c_str());
+        return true;
+    }
+
+    bool isOpen() const {
+        return m_Data != nullptr;
+    }
+
+    const std::string& path() const {
+        return m_Path;
+    }
+
+    // the blob stored under name, or an empty blob
+    PakBlob find(const std::string& name) const {
+        PakBlob blob = find(pakNameHash(name));
+        return blob && name == blob.Name ? blob : PakBlob();
+    }
+
+    // The blob whose name has hash, for references between blobs. Hashes are
+    // unique within a package, PakWriter refuses collisions.
+    PakBlob find(uint64_t hash) const {
+        if (!m_Data) {
+            return {};
+        }
+        const PakEntry* begin = entries();
+        const PakEntry* end = begin + header().EntryCount;
+        const PakEntry* entry = std::lower_bound(begin, end, hash, [](const PakEntry& e, uint64_t h) {
+            return e.NameHash < h;
+        });
+        if (entry == end || entry->NameHash != hash) {
+            return {};
+        }
+        return blob(*entry);
+    }
+
+    // every blob, in table order
+    std::vector<PakBlob> blobs() const {
+        std::vector<PakBlob> all;
+        if (m_Data) {
+            for (uint32_t i = 0; i < header().EntryCount; i++) {
+                all.push_back(blob(entries()[i]));
+            }
+        }
+        return all;
+    }
+
+    size_t size() const {
+        return m_Size;
+    }
+
+    void close() {
+#ifdef RG_PAK_MMAP
+        if (m_Data) {
+            munmap((void*) m_Data, m_Size);
+        }
+#else
+        m_Copy.clear();
+        m_Copy.shrink_to_fit();
+#endif
+        memoryTracker().cpuFreed(this);
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Path.clear();
+    }
+
+private:
+    const unsigned char* m_Data = nullptr;
+    size_t m_Size = 0;
+    std::string m_Path;
+#ifndef RG_PAK_MMAP
+    std::vector<unsigned char> m_Copy;
+#endif
+
+    const PakHeader& header() const {
+        return *(const PakHeader*) m_Data;
+    }
+
+    const PakEntry* entries() const {
+        return (const PakEntry*) (m_Data + sizeof(PakHeader));
+    }
+
+    const char* entryName(const PakEntry& entry) const {
+        return (const char*) m_Data + header().NamesOffset + entry.NameOffset;
+    }
+
+    PakBlob blob(const PakEntry& entry) const {
+        PakBlob blob;
+        blob.Data = m_Data + entry.Offset;
+        blob.Size = entry.Size;
+        blob.Type = entry.Type;
+        blob.Name = entryName(entry);
+        return blob;
+    }
+
+    // Bounds of everything find() touches, so a truncated or foreign file is
+    // rejected here and not by a crash later.
+    bool validate() const {
+        if (m_Size < sizeof(PakHeader)) {
+            return false;
+        }
+        const PakHeader& h = header();
+        if (std::memcmp(h.Magic, kPakMagic, 4) != 0 || h.Version != kPakVersion || h.FileSize != m_Size) {
+            return false;
+        }
+        uint64_t tableEnd = sizeof(PakHeader) + (uint64_t) h.EntryCount * sizeof(PakEntry);
+        if (tableEnd > m_Size || h.NamesOffset < tableEnd || h.NamesOffset + h.NamesSize > m_Size ||
+            (h.NamesSize > 0 && m_Data[h.NamesOffset + h.NamesSize - 1] != '\0')) {
+            return false;
+        }
+        for (uint32_t i = 0; i < h.EntryCount; i++) {
+            const PakEntry& entry = entries()[i];
+            if (entry.NameOffset >= h.NamesSize || entry.Offset % kPakAlignment != 0 || entry.Offset > m_Size ||
+                entry.Size > m_Size - entry.Offset || (i > 0 && entries()[i - 1].NameHash >= entry.NameHash)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Builds a package in memory and writes it in one go. Blobs are laid out in
+// the order they are added.
+class PakWriter {
+public:
+    // False when name, or another name with the same hash, is already in.
+    bool add(const std::string& name, PakBlobType type, std::vector<unsigned char> data) {
+        uint64_t hash = pakNameHash(name);
+        for (const Blob& blob : m_Blobs) {
+            if (blob.Hash == hash) {
+                std::cerr << "PakWriter: " << name << " collides with " << blob.Name << '\n';
+                return false;
+            }
+        }
+        m_Blobs.push_back({name, hash, type, std::move(data)});
+        return true;
+    }
+
+    size_t size() const {
+        return m_Blobs.size();
+    }
+
+    // Writes to a temporary file first and renames it over path, so a running
+    // application that has the old package mapped keeps a consistent view.
+    bool write(const std::string& path) const {
+        std::vector<PakEntry> entries(m_Blobs.size());
+        std::string names;
+        for (size_t i = 0; i < m_Blobs.size(); i++) {
+            entries[i].NameHash = m_Blobs[i].Hash;
+            entries[i].NameOffset = names.size();
+            entries[i].Type = m_Blobs[i].Type;
+            entries[i].Size = m_Blobs[i].Data.size();
+            names += m_Blobs[i].Name;
+            names += '\0';
+        }
+
+        PakHeader header;
+        std::memcpy(header.Magic, kPakMagic, 4);
+        header.Version = kPakVersion;
+        header.EntryCount = entries.size();
+        header.NamesSize = names.size();
+        header.NamesOffset = sizeof(PakHeader) + entries.size() * sizeof(PakEntry);
+        uint64_t offset = alignUp<uint64_t>(header.NamesOffset + names.size(), kPakAlignment);
+        for (PakEntry& entry : entries) {
+            entry.Offset = offset;
+            offset = alignUp(offset + entry.Size, kPakAlignment);
+        }
+        header.FileSize = offset;
+
+        std::vector<PakEntry> table = entries;
+        std::sort(table.begin(), table.end(), [](const PakEntry& a, const PakEntry& b) {
+            return a.NameHash < b.NameHash;
+        });
+
+        std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (!file) {
+            std::cerr << "PakWriter: cannot write " << temporary << '\n';
+            return false;
+        }
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = ok && (table.empty() || std::fwrite(table.data(), sizeof(PakEntry), table.size(), file) == table.size());
+        ok = ok && std::fwrite(names.data(), 1, names.size(), file) == names.size();
+        uint64_t written = header.NamesOffset + names.size();
+        for (size_t i = 0; ok && i < m_Blobs.size(); i++) {
+            ok = pad(file, entries[i].Offset - written);
+            ok = ok && std::fwrite(m_Blobs[i].Data.data(), 1, m_Blobs[i].Data.size(), file) == m_Blobs[i].Data.size();
+            written = entries[i].Offset + entries[i].Size;
+        }
+        ok = ok && pad(file, header.FileSize - written);
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::cerr << "PakWriter: writing " << path << " failed\n";
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Blob {
+        std::string Name;
+        uint64_t Hash;
+        PakBlobType Type;
+        std::vector<unsigned char> Data;
+    };
+
+    std::vector<Blob> m_Blobs;
+
+    static bool pad(std::FILE* file, uint64_t bytes) {
+        static const char zeros[kPakAlignment] = {};
+        return bytes < kPakAlignment && std::fwrite(zeros, 1, bytes, file) == bytes;
+    }
+};
+
+// the package the application loads assets from, empty until opened
+inline PakFile& pak() {
+    static PakFile instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_PAK_H
@@ -0,0 +1,117 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_PNG_H
+#define PROJECT_BASE_PNG_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+namespace png_detail {
+
+inline uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        tableReady = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+inline void writeChunk(std::FILE* file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> chunk;
+    putU32(chunk, data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // the CRC covers the type and the data, not the length
+    putU32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+    std::fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+};
+
+// Writes 8 bit RGB (channels = 3) or RGBA (channels = 4) pixels, rows top to
+// bottom, as a PNG. The image data is stored uncompressed: files are larger than
+// they could be, but no zlib is needed and writing is fast.
+inline bool writePng(const std::string& path, int width, int height, int channels, const uint8_t* pixels) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    std::vector<uint8_t> header;
+    png_detail::putU32(header, width);
+    png_detail::putU32(header, height);
+    header.push_back(8);                       // bit depth
+    header.push_back(channels == 4 ? 6 : 2);   // colour type: RGBA or RGB
+    header.push_back(0);                       // deflate
+    header.push_back(0);                       // adaptive filtering
+    header.push_back(0);                       // no interlace
+    png_detail::writeChunk(file, "IHDR", header);
+
+    // filter type 0 in front of every row
+    size_t rowSize = (size_t) width * channels;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+    }
+
+    // zlib stream made of stored deflate blocks of at most 65535 bytes
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(blockSize & 0xff);
+        zlib.push_back(blockSize >> 8);
+        zlib.push_back(~blockSize & 0xff);
+        zlib.push_back((~blockSize >> 8) & 0xff);
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    png_detail::putU32(zlib, (b << 16) | a);
+    png_detail::writeChunk(file, "IDAT", zlib);
+    png_detail::writeChunk(file, "IEND", {});
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+};
+
+#endif //PROJECT_BASE_PNG_H
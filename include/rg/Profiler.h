@@ -0,0 +1,494 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_PROFILER_H
+#define PROJECT_BASE_PROFILER_H
+
+#include <glad/glad.h>
+#include <rg/Json.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rg {
+
+enum class ProfileKind {
+    // CPU timer only
+    Cpu,
+    // render pass: CPU timer plus a GPU query, only recorded while Detailed is on
+    Pass,
+    // coarse frame span, always GPU timed; while Detailed is on it only groups the
+    // passes inside it and its GPU time is their sum
+    Span
+};
+
+struct ProfileRecord {
+    const char* name;
+    int depth;
+    int parent;
+    ProfileKind kind;
+    double cpuBeginMs;
+    double cpuMs;
+    int query;
+    double gpuMs;
+};
+
+struct ProfileStats {
+    float cpuMs = 0.0f;
+    float gpuMs = 0.0f;
+};
+
+// One complete ("ph": "X") event of a Chrome trace.
+struct TraceEvent {
+    std::string name;
+    double beginMs;
+    double durationMs;
+    // thread index from Profiler::threadIndex(), or kGpuTrack
+    int track;
+};
+
+// CPU scope timers paired with GL_TIME_ELAPSED queries. Every frame gets its own
+// set of queries from a ring of kLatency frames, so results are read back kLatency
+// frames after they were issued and reading never waits for the GPU.
+// GL_TIME_ELAPSED queries cannot nest, which is why passes and spans never both
+// issue queries in the same frame. With Detailed off, a pass scope costs one
+// branch and a push/pop.
+//
+// Captures dump CPU scopes of every thread and the GPU pass timings of a number of
+// frames into a Chrome Trace Event file (chrome://tracing, ui.perfetto.dev).
+// CPU scopes that run before the first frame (asset loading) are always kept and
+// are part of every capture. Scopes on threads other than the one that called
+// init() are CPU only and only cost anything while a capture is running.
+class Profiler {
+public:
+    static const int kLatency = 4;
+    static const int kHistory = 240;
+    static const int kGpuTrack = -1;
+
+    bool Detailed = false;
+    // Block on late query results instead of dropping the frame, for benchmarks
+    // that need the GPU time of every frame.
+    bool WaitForResults = false;
+
+    void init() {
+        m_RenderThread = std::this_thread::get_id();
+        setThreadName("Main");
+    }
+
+    // GPU timed scopes and frames are recorded by the thread that owns the GL
+    // context, which is the thread that called init() until this hands it over.
+    // Scopes on every other thread are CPU only.
+    void setRenderThread(std::thread::id id) {
+        m_RenderThread = id;
+    }
+
+    void destroy() {
+        for (FrameSlot& slot : m_Slots) {
+            if (!slot.queries.empty()) {
+                glDeleteQueries(slot.queries.size(), slot.queries.data());
+                slot.queries.clear();
+            }
+        }
+    }
+
+    void beginFrame() {
+        FrameSlot& slot = m_Slots[m_Frame % kLatency];
+        if (slot.pending) {
+            collect(slot);
+        }
+        if (m_Frame == 0) {
+            // everything recorded so far happened during startup
+            std::lock_guard<std::mutex> lock(m_EventsMutex);
+            m_StartupEvents.swap(m_Events);
+            m_Events.clear();
+        }
+        if (m_CaptureWritePending && m_Frame >= m_CaptureEndFrame + kLatency) {
+            writeCapture();
+        }
+        if (m_CaptureFramesRequested > 0 && !m_CaptureWritePending) {
+            // captures start on a frame boundary
+            m_CaptureEndFrame = m_Frame + m_CaptureFramesRequested;
+            m_CaptureFramesRequested = 0;
+            m_CaptureWritePending = true;
+        }
+        slot.captured = m_CaptureWritePending && m_Frame < m_CaptureEndFrame;
+        m_Recording = slot.captured;
+
+        slot.frame = m_Frame;
+        slot.records.clear();
+        slot.queriesUsed = 0;
+        slot.pending = false;
+        m_Stack.clear();
+        m_GpuActive = false;
+        m_FrameDetailed = Detailed || slot.captured;
+        m_FrameBeginMs = nowMs();
+    }
+
+    void endFrame() {
+        FrameSlot& slot = m_Slots[m_Frame % kLatency];
+        slot.cpuFrameMs = nowMs() - m_FrameBeginMs;
+        slot.pending = true;
+        m_CpuHistory[m_Frame % kHistory] = (float) slot.cpuFrameMs;
+        if (slot.captured) {
+            recordEvent("Frame", m_FrameBeginMs, slot.cpuFrameMs, threadIndex());
+        }
+        ++m_Frame;
+    }
+
+    // Dumps the startup scopes plus the next frames frames to path once their GPU
+    // results are in. Ignored while another capture is in flight.
+    void requestCapture(int frames, const std::string& path) {
+        if (m_CaptureWritePending || frames <= 0) {
+            return;
+        }
+        m_CaptureFramesRequested = frames;
+        m_CapturePath = path;
+        std::cout << "Capturing " << frames << " frames to " << path << std::endl;
+    }
+
+    bool capturing() const {
+        return m_CaptureWritePending || m_CaptureFramesRequested > 0;
+    }
+
+    // CPU-only scope that may run on any thread and may carry a runtime name,
+    // e.g. the path of the asset being loaded.
+    void beginCpuScope(const std::string& name) {
+        CpuScope scope;
+        scope.recording = m_Recording.load(std::memory_order_relaxed);
+        if (scope.recording) {
+            scope.name = name;
+            scope.beginMs = nowMs();
+        }
+        cpuStack().push_back(scope);
+    }
+
+    void endCpuScope() {
+        std::vector<CpuScope>& stack = cpuStack();
+        if (stack.empty()) {
+            return;
+        }
+        const CpuScope& scope = stack.back();
+        if (scope.recording) {
+            recordEvent(scope.name, scope.beginMs, nowMs() - scope.beginMs, threadIndex());
+        }
+        stack.pop_back();
+    }
+
+    // Label for the calling thread in captures.
+    void setThreadName(const std::string& name) {
+        int index = threadIndex();
+        std::lock_guard<std::mutex> lock(m_EventsMutex);
+        m_ThreadNames[index] = name;
+    }
+
+    void beginScope(const char* name, ProfileKind kind = ProfileKind::Pass) {
+        if (kind == ProfileKind::Cpu || std::this_thread::get_id() != m_RenderThread) {
+            beginCpuScope(name);
+            if (std::this_thread::get_id() == m_RenderThread) {
+                m_Stack.push_back(kCpuScope);
+            }
+            return;
+        }
+        if (kind == ProfileKind::Pass && !m_FrameDetailed) {
+            m_Stack.push_back(-1);
+            return;
+        }
+        FrameSlot& slot = m_Slots[m_Frame % kLatency];
+        ProfileRecord record;
+        record.name = name;
+        record.depth = m_Stack.size();
+        record.parent = m_Stack.empty() ? -1 : m_Stack.back();
+        record.kind = kind;
+        record.cpuBeginMs = nowMs();
+        record.cpuMs = 0.0;
+        record.query = -1;
+        record.gpuMs = 0.0;
+
+        bool timeOnGpu = (kind == ProfileKind::Pass) || (kind == ProfileKind::Span && !m_FrameDetailed);
+        if (timeOnGpu && !m_GpuActive) {
+            if (slot.queriesUsed == (int) slot.queries.size()) {
+                unsigned int query;
+                glGenQueries(1, &query);
+                slot.queries.push_back(query);
+            }
+            record.query = slot.queriesUsed++;
+            glBeginQuery(GL_TIME_ELAPSED, slot.queries[record.query]);
+            m_GpuActive = true;
+        }
+        slot.records.push_back(record);
+        m_Stack.push_back(slot.records.size() - 1);
+    }
+
+    void endScope() {
+        if (std::this_thread::get_id() != m_RenderThread) {
+            endCpuScope();
+            return;
+        }
+        if (m_Stack.empty()) {
+            return;
+        }
+        int index = m_Stack.back();
+        m_Stack.pop_back();
+        if (index == kCpuScope) {
+            endCpuScope();
+            return;
+        }
+        if (index < 0) {
+            return;
+        }
+        FrameSlot& slot = m_Slots[m_Frame % kLatency];
+        ProfileRecord& record = slot.records[index];
+        if (record.query >= 0) {
+            glEndQuery(GL_TIME_ELAPSED);
+            m_GpuActive = false;
+        }
+        record.cpuMs = nowMs() - record.cpuBeginMs;
+        if (slot.captured) {
+            recordEvent(record.name, record.cpuBeginMs, record.cpuMs, threadIndex());
+        }
+    }
+
+    // Records of the newest frame whose GPU results are back, in begin order.
+    const std::vector<ProfileRecord>& lastFrame() const {
+        return m_Completed;
+    }
+
+    // Smoothed timings of a scope by name, averaged over completed frames.
+    ProfileStats stats(const char* name) const {
+        auto it = m_Stats.find(name);
+        return it == m_Stats.end() ? ProfileStats() : it->second;
+    }
+
+    // GPU time of a scope in the newest completed frame, 0 if it did not run.
+    double lastGpuMs(const char* name) const {
+        for (const ProfileRecord& record : m_Completed) {
+            if (std::strcmp(record.name, name) == 0) {
+                return record.gpuMs;
+            }
+        }
+        return 0.0;
+    }
+
+    bool hasResult() const { return m_HasResult; }
+    // Index of the frame lastFrame() belongs to, counting beginFrame() calls from 0.
+    unsigned int completedFrame() const { return m_CompletedFrame; }
+    double lastGpuFrameMs() const { return m_LastGpuFrameMs; }
+    double lastCpuFrameMs() const { return m_LastCpuFrameMs; }
+
+    // Rolling per-frame history for graphs; offset is the oldest entry.
+    const float* cpuHistory() const { return m_CpuHistory; }
+    const float* gpuHistory() const { return m_GpuHistory; }
+    int historyOffset() const { return m_Frame % kHistory; }
+
+private:
+    static const int kCpuScope = -2;
+
+    struct FrameSlot {
+        std::vector<ProfileRecord> records;
+        std::vector<unsigned int> queries;
+        int queriesUsed = 0;
+        bool pending = false;
+        bool captured = false;
+        double cpuFrameMs = 0.0;
+        // the frame the queries measure, kLatency frames before they are read
+        unsigned int frame = 0;
+    };
+
+    struct CpuScope {
+        bool recording;
+        std::string name;
+        double beginMs;
+    };
+
+    FrameSlot m_Slots[kLatency];
+    std::vector<int> m_Stack;
+    std::vector<ProfileRecord> m_Completed;
+    std::map<std::string, ProfileStats> m_Stats;
+    float m_CpuHistory[kHistory] = {};
+    float m_GpuHistory[kHistory] = {};
+    std::thread::id m_RenderThread;
+    std::chrono::steady_clock::time_point m_Epoch = std::chrono::steady_clock::now();
+
+    // startup scopes are recorded until the first frame begins
+    std::atomic<bool> m_Recording{true};
+    std::atomic<int> m_NextThreadIndex{0};
+    std::mutex m_EventsMutex;
+    std::vector<TraceEvent> m_Events;
+    std::vector<TraceEvent> m_StartupEvents;
+    std::map<int, std::string> m_ThreadNames;
+    int m_CaptureFramesRequested = 0;
+    unsigned int m_CaptureEndFrame = 0;
+    bool m_CaptureWritePending = false;
+    std::string m_CapturePath;
+    unsigned int m_Frame = 0;
+    unsigned int m_CompletedFrame = 0;
+    bool m_GpuActive = false;
+    bool m_FrameDetailed = false;
+    bool m_HasResult = false;
+    double m_FrameBeginMs = 0.0;
+    double m_LastGpuFrameMs = 0.0;
+    double m_LastCpuFrameMs = 0.0;
+    double m_GpuTrackEndMs = 0.0;
+
+    double nowMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Epoch).count();
+    }
+
+    int threadIndex() {
+        thread_local int index = m_NextThreadIndex++;
+        return index;
+    }
+
+    static std::vector<CpuScope>& cpuStack() {
+        thread_local std::vector<CpuScope> stack;
+        return stack;
+    }
+
+    void recordEvent(const std::string& name, double beginMs, double durationMs, int track) {
+        TraceEvent event;
+        event.name = name;
+        event.beginMs = beginMs;
+        event.durationMs = durationMs;
+        event.track = track;
+        std::lock_guard<std::mutex> lock(m_EventsMutex);
+        m_Events.push_back(event);
+    }
+
+    // GL_TIME_ELAPSED only gives durations, so GPU passes are laid out back to back
+    // on their own track, none starting before the CPU submitted it.
+    void recordGpuEvents(const FrameSlot& slot) {
+        for (const ProfileRecord& record : slot.records) {
+            if (record.query < 0) {
+                continue;
+            }
+            double beginMs = std::max(record.cpuBeginMs, m_GpuTrackEndMs);
+            recordEvent(record.name, beginMs, record.gpuMs, kGpuTrack);
+            m_GpuTrackEndMs = beginMs + record.gpuMs;
+        }
+    }
+
+    void writeCapture() {
+        m_CaptureWritePending = false;
+        std::lock_guard<std::mutex> lock(m_EventsMutex);
+        std::ofstream out(m_CapturePath);
+        if (!out) {
+            std::cerr << "Failed to write trace " << m_CapturePath << std::endl;
+            m_Events.clear();
+            return;
+        }
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"CPU\"}},\n";
+        out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"GPU\"}}";
+        for (const auto& thread : m_ThreadNames) {
+            out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread.first
+                << ", \"args\": {\"name\": " << jsonString(thread.second) << "}}";
+        }
+        const std::vector<TraceEvent>* lists[] = {&m_StartupEvents, &m_Events};
+        for (const std::vector<TraceEvent>* events : lists) {
+            for (const TraceEvent& event : *events) {
+                bool gpu = event.track == kGpuTrack;
+                out << ",\n{\"name\": " << jsonString(event.name) << ", \"ph\": \"X\""
+                    << ", \"pid\": " << (gpu ? 2 : 1) << ", \"tid\": " << (gpu ? 0 : event.track)
+                    << ", \"ts\": " << (long long) (event.beginMs * 1000.0)
+                    << ", \"dur\": " << (long long) (event.durationMs * 1000.0) << "}";
+            }
+        }
+        out << "\n]}\n";
+        std::cout << "Wrote trace " << m_CapturePath << " (" << m_Events.size() << " events)" << std::endl;
+        m_Events.clear();
+    }
+
+    void collect(FrameSlot& slot) {
+        slot.pending = false;
+        if (slot.queriesUsed > 0) {
+            // queries finish in order, so the last one being ready means all are
+            GLint available = 0;
+            glGetQueryObjectiv(slot.queries[slot.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            // a capture must contain the GPU side of every frame it covers, so those
+            // frames wait for their results instead of being dropped
+            if (!available && !slot.captured && !WaitForResults) {
+                return;
+            }
+        }
+        double gpuFrameMs = 0.0;
+        for (ProfileRecord& record : slot.records) {
+            if (record.query >= 0) {
+                GLuint64 elapsedNs = 0;
+                glGetQueryObjectui64v(slot.queries[record.query], GL_QUERY_RESULT, &elapsedNs);
+                record.gpuMs = elapsedNs / 1.0e6;
+                gpuFrameMs += record.gpuMs;
+            }
+        }
+        // children come after their parent, so a reverse walk sums groups bottom-up
+        for (int i = (int) slot.records.size() - 1; i >= 0; --i) {
+            const ProfileRecord& record = slot.records[i];
+            if (record.parent >= 0 && slot.records[record.parent].query < 0) {
+                slot.records[record.parent].gpuMs += record.gpuMs;
+            }
+        }
+
+        if (slot.captured) {
+            recordGpuEvents(slot);
+        }
+        m_Completed = slot.records;
+        m_CompletedFrame = slot.frame;
+        m_LastGpuFrameMs = gpuFrameMs;
+        m_LastCpuFrameMs = slot.cpuFrameMs;
+        // next to the CPU time of the same frame
+        m_GpuHistory[slot.frame % kHistory] = (float) gpuFrameMs;
+        m_HasResult = true;
+        for (const ProfileRecord& record : m_Completed) {
+            ProfileStats& stats = m_Stats[record.name];
+            stats.cpuMs += ((float) record.cpuMs - stats.cpuMs) * 0.1f;
+            stats.gpuMs += ((float) record.gpuMs - stats.gpuMs) * 0.1f;
+        }
+    }
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// Scope guard for code that maps onto a C++ block.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name, ProfileKind kind = ProfileKind::Pass)
+        : m_Cpu(false) {
+        profiler().beginScope(name, kind);
+    }
+
+    explicit ProfileScope(const std::string& name)
+        : m_Cpu(true) {
+        profiler().beginCpuScope(name);
+    }
+
+    ~ProfileScope() {
+        if (m_Cpu) {
+            profiler().endCpuScope();
+        } else {
+            profiler().endScope();
+        }
+    }
+
+private:
+    bool m_Cpu;
+};
+
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) rg::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name, rg::ProfileKind::Pass)
+#define PROFILE_CPU_SCOPE(name) rg::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(std::string(name))
+
+#endif //PROJECT_BASE_PROFILER_H
@@ -0,0 +1,351 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_REGRESSION_H
+#define PROJECT_BASE_REGRESSION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <stb_image.h>
+#include <rg/Benchmark.h>
+#include <rg/DrawStats.h>
+#include <rg/Json.h>
+#include <rg/Png.h>
+#include <rg/Profiler.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// One canonical view of the scene. Animations are frozen at time so the image
+// only depends on the renderer.
+struct RegressionPose {
+    std::string name;
+    CameraKeyframe camera;
+
+    // filled in while running
+    std::vector<double> cpuFrameMs;
+    std::vector<double> gpuFrameMs;
+    unsigned long long drawCalls = 0;
+    unsigned long long triangles = 0;
+    bool imageChecked = false;
+    bool imagePassed = false;
+    double differentPixels = 0.0;
+};
+
+// Renders every pose of a config for FramesPerPose frames, compares the last
+// frame against a golden PNG and the frame cost against a checked-in baseline:
+//
+//   {
+//     "width": 1280, "height": 720, "framesPerPose": 16,
+//     "golden": "resources/regression/golden", "baseline": "resources/regression/baseline.json",
+//     "maxDeltaE": 10, "maxDifferentPixels": 0.005, "timeTolerance": 0.25,
+//     "poses": [{"name": "street", "position": [2, 3.4, 18.2], "yaw": -91.4, "pitch": -4.5, "time": 0}]
+//   }
+//
+// Images are compared in CIELAB: a pixel differs when its delta E exceeds
+// maxDeltaE, and a pose fails when more than maxDifferentPixels of its pixels
+// differ, so the small noise of a different driver passes but a missing object
+// or a shifted edge does not. Frame times may exceed the baseline by
+// timeTolerance; draw call and triangle counts are exact budgets.
+// Goldens depend on the rasterizer, keep one set per CI renderer (llvmpipe).
+class RegressionSuite {
+public:
+    int Width = 1280;
+    int Height = 720;
+    // enough frames for TAA to cycle through all jitter phases and converge
+    int FramesPerPose = 16;
+    std::string GoldenDir = "resources/regression/golden";
+    std::string BaselinePath = "resources/regression/baseline.json";
+    std::string OutputDir = ".";
+    double MaxDeltaE = 10.0;
+    double MaxDifferentPixels = 0.005;
+    double TimeTolerance = 0.25;
+    // write goldens / baseline from this run instead of checking against them
+    bool UpdateGolden = false;
+    bool UpdateBaseline = false;
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Failed to open regression config " << path << std::endl;
+            return false;
+        }
+        std::stringstream text;
+        text << in.rdbuf();
+        std::string error;
+        if (!JsonValue::parse(text.str(), m_Settings, error)) {
+            std::cerr << "Failed to parse regression config " << path << ": " << error << std::endl;
+            return false;
+        }
+        Width = (int) m_Settings["width"].asNumber(Width);
+        Height = (int) m_Settings["height"].asNumber(Height);
+        FramesPerPose = std::max(1, (int) m_Settings["framesPerPose"].asNumber(FramesPerPose));
+        GoldenDir = m_Settings["golden"].asString(GoldenDir);
+        BaselinePath = m_Settings["baseline"].asString(BaselinePath);
+        OutputDir = m_Settings["output"].asString(OutputDir);
+        MaxDeltaE = m_Settings["maxDeltaE"].asNumber(MaxDeltaE);
+        MaxDifferentPixels = m_Settings["maxDifferentPixels"].asNumber(MaxDifferentPixels);
+        TimeTolerance = m_Settings["timeTolerance"].asNumber(TimeTolerance);
+
+        const JsonValue& poses = m_Settings["poses"];
+        m_Poses.clear();
+        for (size_t i = 0; i < poses.size(); i++) {
+            const JsonValue& pose = poses[i];
+            const JsonValue& position = pose["position"];
+            RegressionPose regressionPose;
+            regressionPose.name = pose["name"].asString("pose" + std::to_string(i));
+            regressionPose.camera.time = (float) pose["time"].asNumber();
+            regressionPose.camera.position =
+                    glm::vec3(position[0].asNumber(), position[1].asNumber(), position[2].asNumber());
+            regressionPose.camera.yaw = (float) pose["yaw"].asNumber(-90.0);
+            regressionPose.camera.pitch = (float) pose["pitch"].asNumber();
+            m_Poses.push_back(regressionPose);
+        }
+        if (m_Poses.empty()) {
+            std::cerr << "Regression config " << path << " has no poses" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const JsonValue& settings() const {
+        return m_Settings;
+    }
+
+    int totalFrames() const {
+        return (int) m_Poses.size() * FramesPerPose;
+    }
+
+    // Pose shown in a frame; frames past the end keep the last pose while the
+    // profiler results of the last frames come in.
+    const RegressionPose& pose(int frame) const {
+        return m_Poses[std::min(frame / FramesPerPose, (int) m_Poses.size() - 1)];
+    }
+
+    bool captureFrame(int frame) const {
+        return frame < totalFrames() && frame % FramesPerPose == FramesPerPose - 1;
+    }
+
+    // True once every pose has been captured and all GPU timings are in.
+    bool done() const {
+        return m_LastProfiledFrame >= totalFrames() - 1;
+    }
+
+    // Reads the finished frame from the bound read framebuffer and checks it
+    // against the pose's golden image. Call before swapping buffers.
+    void checkImage(int frame, int width, int height) {
+        if (!captureFrame(frame)) {
+            return;
+        }
+        RegressionPose& current = m_Poses[frame / FramesPerPose];
+        std::vector<uint8_t> pixels((size_t) width * height * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        // GL rows go bottom to top, PNG rows top to bottom
+        size_t rowSize = (size_t) width * 3;
+        for (int y = 0; y < height / 2; y++) {
+            std::swap_ranges(pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize,
+                             pixels.begin() + (height - 1 - y) * rowSize);
+        }
+
+        current.imageChecked = true;
+        std::string goldenPath = GoldenDir + "/" + current.name + ".png";
+        if (UpdateGolden) {
+            current.imagePassed = writePng(goldenPath, width, height, 3, pixels.data());
+            if (!current.imagePassed) {
+                std::cerr << "Failed to write " << goldenPath << std::endl;
+            }
+            return;
+        }
+
+        int goldenWidth, goldenHeight, goldenChannels;
+        stbi_set_flip_vertically_on_load(false);
+        unsigned char* golden = stbi_load(goldenPath.c_str(), &goldenWidth, &goldenHeight, &goldenChannels, 3);
+        if (!golden) {
+            std::cerr << "Missing golden image " << goldenPath << " (run with --update-golden)" << std::endl;
+        } else if (goldenWidth != width || goldenHeight != height) {
+            std::cerr << "Golden image " << goldenPath << " is " << goldenWidth << "x" << goldenHeight
+                      << ", frame is " << width << "x" << height << std::endl;
+        } else {
+            std::vector<uint8_t> diff(pixels.size());
+            size_t different = 0;
+            for (size_t i = 0; i < pixels.size(); i += 3) {
+                double deltaE = glm::length(toLab(&pixels[i]) - toLab(&golden[i]));
+                bool differs = deltaE > MaxDeltaE;
+                different += differs;
+                // differing pixels in red over a darkened copy of the frame
+                diff[i] = differs ? 255 : pixels[i] / 4;
+                diff[i + 1] = differs ? 0 : pixels[i + 1] / 4;
+                diff[i + 2] = differs ? 0 : pixels[i + 2] / 4;
+            }
+            current.differentPixels = (double) different / (width * height);
+            current.imagePassed = current.differentPixels <= MaxDifferentPixels;
+            if (!current.imagePassed) {
+                writePng(OutputDir + "/" + current.name + "_actual.png", width, height, 3, pixels.data());
+                writePng(OutputDir + "/" + current.name + "_diff.png", width, height, 3, diff.data());
+            }
+        }
+        stbi_image_free(golden);
+    }
+
+    void recordFrame(int frame, const DrawStats& draws) {
+        if (frame >= totalFrames()) {
+            return;
+        }
+        RegressionPose& current = m_Poses[frame / FramesPerPose];
+        current.drawCalls = std::max(current.drawCalls, draws.drawCalls);
+        current.triangles = std::max(current.triangles, draws.triangles);
+    }
+
+    void recordProfile(const Profiler& profiler) {
+        if (!profiler.hasResult()) {
+            return;
+        }
+        int frame = (int) profiler.completedFrame();
+        if (frame >= totalFrames() || frame == m_LastProfiledFrame) {
+            return;
+        }
+        m_LastProfiledFrame = frame;
+        // the first frame of a pose pays for the camera jump (and for the very
+        // first pose, shader compilation), leave it out
+        if (frame % FramesPerPose == 0) {
+            return;
+        }
+        RegressionPose& current = m_Poses[frame / FramesPerPose];
+        current.cpuFrameMs.push_back(profiler.lastCpuFrameMs());
+        current.gpuFrameMs.push_back(profiler.lastGpuFrameMs());
+    }
+
+    // Prints a summary, checks or rewrites the baseline and returns whether every
+    // pose passed.
+    bool finish() {
+        JsonValue baseline;
+        bool haveBaseline = false;
+        if (!UpdateBaseline) {
+            std::ifstream in(BaselinePath);
+            std::stringstream text;
+            text << in.rdbuf();
+            std::string error;
+            haveBaseline = in && JsonValue::parse(text.str(), baseline, error);
+            if (!haveBaseline) {
+                std::cerr << "Missing or invalid baseline " << BaselinePath << " (run with --update-baseline)"
+                          << std::endl;
+            }
+        }
+
+        bool passed = true;
+        std::cout << std::fixed << std::setprecision(2);
+        for (const RegressionPose& current : m_Poses) {
+            double cpuMs = median(current.cpuFrameMs);
+            double gpuMs = median(current.gpuFrameMs);
+            std::vector<std::string> failures;
+            if (!current.imageChecked || !current.imagePassed) {
+                std::ostringstream failure;
+                failure << "image (" << current.differentPixels * 100.0 << "% pixels differ)";
+                failures.push_back(failure.str());
+            }
+            if (haveBaseline) {
+                const JsonValue& budget = baseline["poses"][current.name];
+                if (budget.isNull()) {
+                    failures.push_back("no baseline");
+                } else {
+                    checkTime("CPU", cpuMs, budget["cpuFrameMs"].asNumber(), failures);
+                    checkTime("GPU", gpuMs, budget["gpuFrameMs"].asNumber(), failures);
+                    checkCount("draw calls", current.drawCalls, budget["drawCalls"].asNumber(), failures);
+                    checkCount("triangles", current.triangles, budget["triangles"].asNumber(), failures);
+                }
+            } else if (!UpdateBaseline) {
+                failures.push_back("no baseline");
+            }
+
+            std::cout << (failures.empty() ? "[PASS] " : "[FAIL] ") << current.name << ": CPU " << cpuMs
+                      << " ms, GPU " << gpuMs << " ms, " << current.drawCalls << " draws, " << current.triangles
+                      << " triangles";
+            for (const std::string& failure : failures) {
+                std::cout << "\n    " << failure;
+            }
+            std::cout << std::endl;
+            passed &= failures.empty();
+        }
+
+        if (UpdateBaseline) {
+            passed &= writeBaseline();
+        }
+        return passed;
+    }
+
+private:
+    JsonValue m_Settings;
+    std::vector<RegressionPose> m_Poses;
+    int m_LastProfiledFrame = -1;
+
+    static double median(std::vector<double> samples) {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    void checkTime(const char* what, double ms, double budgetMs, std::vector<std::string>& failures) const {
+        if (budgetMs > 0.0 && ms > budgetMs * (1.0 + TimeTolerance)) {
+            std::ostringstream failure;
+            failure << std::fixed << std::setprecision(2) << what << " " << ms << " ms over budget " << budgetMs
+                    << " ms";
+            failures.push_back(failure.str());
+        }
+    }
+
+    static void checkCount(const char* what, unsigned long long count, double budget,
+                           std::vector<std::string>& failures) {
+        if (budget > 0.0 && count > budget) {
+            std::ostringstream failure;
+            failure << what << " " << count << " over budget " << (unsigned long long) budget;
+            failures.push_back(failure.str());
+        }
+    }
+
+    bool writeBaseline() const {
+        std::ofstream out(BaselinePath);
+        if (!out) {
+            std::cerr << "Failed to write baseline " << BaselinePath << std::endl;
+            return false;
+        }
+        out << "{\n  \"poses\": {";
+        for (size_t i = 0; i < m_Poses.size(); i++) {
+            const RegressionPose& current = m_Poses[i];
+            out << (i == 0 ? "\n" : ",\n") << "    " << jsonString(current.name) << ": {\"cpuFrameMs\": "
+                << median(current.cpuFrameMs) << ", \"gpuFrameMs\": " << median(current.gpuFrameMs)
+                << ", \"drawCalls\": " << current.drawCalls << ", \"triangles\": " << current.triangles << "}";
+        }
+        out << "\n  }\n}\n";
+        std::cout << "Wrote baseline " << BaselinePath << std::endl;
+        return true;
+    }
+
+    // 8 bit sRGB to CIELAB (D65)
+    static glm::vec3 toLab(const uint8_t* rgb) {
+        double linear[3];
+        for (int i = 0; i < 3; i++) {
+            double c = rgb[i] / 255.0;
+            linear[i] = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        }
+        double x = (0.4124 * linear[0] + 0.3576 * linear[1] + 0.1805 * linear[2]) / 0.95047;
+        double y = 0.2126 * linear[0] + 0.7152 * linear[1] + 0.0722 * linear[2];
+        double z = (0.0193 * linear[0] + 0.1192 * linear[1] + 0.9505 * linear[2]) / 1.08883;
+        auto f = [](double t) { return t > 0.008856 ? std::cbrt(t) : 7.787 * t + 16.0 / 116.0; };
+        return glm::vec3(116.0 * f(y) - 16.0, 500.0 * (f(x) - f(y)), 200.0 * (f(y) - f(z)));
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_REGRESSION_H
@@ -0,0 +1,248 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_RENDERTARGET_H
+#define PROJECT_BASE_RENDERTARGET_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <rg/GLState.h>
+#include <rg/MemoryTracker.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+struct ColorAttachment {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    GLenum filter;
+    unsigned int texture = 0;
+};
+
+// Offscreen framebuffer whose storage follows the window size, while rendering can
+// happen into a scaled sub-rectangle of it. Storage is only reallocated when the
+// window size actually changes; changing the scale just moves the viewport, so the
+// dynamic resolution controller can adjust it every frame for free.
+// With samples > 1 the attachments are multisampled renderbuffers that cannot be
+// sampled directly; resolveTo() blits them into a single sampled target.
+class RenderTarget {
+public:
+    explicit RenderTarget(std::vector<ColorAttachment> attachments, bool depthStencil = true,
+                          int samples = 1)
+        : m_Attachments(attachments)
+        , m_HasDepthStencil(depthStencil)
+        , m_Samples(samples) {
+    }
+
+    // Makes sure storage matches the window size. Cheap when nothing changed.
+    // Returns true when the storage was reallocated and its contents are gone.
+    bool resize(int width, int height) {
+        if (width <= 0 || height <= 0) {
+            return false;
+        }
+        if (width == m_Width && height == m_Height) {
+            return false;
+        }
+        m_Width = width;
+        m_Height = height;
+        allocate();
+        setScale(m_Scale);
+        return true;
+    }
+
+    // Renders into scale * window size; the rest of the storage is left untouched.
+    void setScale(float scale) {
+        m_Scale = scale;
+        m_ViewportWidth = std::max(1, (int) std::ceil(m_Width * scale));
+        m_ViewportHeight = std::max(1, (int) std::ceil(m_Height * scale));
+    }
+
+    void bind() const {
+        GLState& state = glState();
+        state.bindFramebuffer(GL_FRAMEBUFFER, m_Fbo);
+        state.viewport(0, 0, m_ViewportWidth, m_ViewportHeight);
+    }
+
+    // Multiplier that maps [0, 1] texture coordinates onto the rendered sub-rectangle.
+    glm::vec2 uvScale() const {
+        return glm::vec2((float) m_ViewportWidth / m_Width, (float) m_ViewportHeight / m_Height);
+    }
+
+    unsigned int colorTexture(int index = 0) const {
+        return m_Attachments[index].texture;
+    }
+
+    unsigned int framebuffer() const {
+        return m_Fbo;
+    }
+
+    // Resolves the rendered sub-rectangle of every attachment, depth and stencil
+    // included, into the same region of dst. Both targets must share size and scale.
+    void resolveTo(const RenderTarget& dst) const {
+        GLState& state = glState();
+        state.bindFramebuffer(GL_READ_FRAMEBUFFER, m_Fbo);
+        state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, dst.m_Fbo);
+        for (unsigned int i = 0; i < m_Attachments.size(); ++i) {
+            GLenum buffer = GL_COLOR_ATTACHMENT0 + i;
+            glReadBuffer(buffer);
+            glDrawBuffers(1, &buffer);
+            GLbitfield mask = GL_COLOR_BUFFER_BIT;
+            if (i == 0 && m_HasDepthStencil && dst.m_HasDepthStencil) {
+                mask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+            }
+            glBlitFramebuffer(0, 0, m_ViewportWidth, m_ViewportHeight,
+                              0, 0, m_ViewportWidth, m_ViewportHeight, mask, GL_NEAREST);
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        dst.setDrawBuffers();
+        state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Renders with the depth-stencil buffer of source, e.g. to depth test against
+    // the scene without writing to its colour attachments; nullptr detaches it.
+    // Only for targets created without their own, of the same size and sample
+    // count as source. Call again after either one was reallocated.
+    void attachDepthStencil(const RenderTarget* source) {
+        unsigned int renderbuffer = source ? source->m_DepthStencil : 0;
+        if (m_HasDepthStencil || !m_Fbo || renderbuffer == m_AttachedDepthStencil) {
+            return;
+        }
+        GLState& state = glState();
+        state.bindFramebuffer(GL_FRAMEBUFFER, m_Fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffer);
+        state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        m_AttachedDepthStencil = renderbuffer;
+    }
+
+    // the owner of the attachments in rg::memoryTracker()
+    void setName(const std::string& name) {
+        m_Name = name;
+    }
+
+    int samples() const { return m_Samples; }
+    int width() const { return m_Width; }
+    int height() const { return m_Height; }
+    int viewportWidth() const { return m_ViewportWidth; }
+    int viewportHeight() const { return m_ViewportHeight; }
+    float scale() const { return m_Scale; }
+
+    void destroy() {
+        release();
+        m_Width = m_Height = 0;
+    }
+
+private:
+    std::vector<ColorAttachment> m_Attachments;
+    bool m_HasDepthStencil;
+    int m_Samples;
+    std::vector<unsigned int> m_ColorRenderbuffers;
+    unsigned int m_Fbo = 0;
+    unsigned int m_DepthStencil = 0;
+    // another target's depth-stencil buffer, see attachDepthStencil()
+    unsigned int m_AttachedDepthStencil = 0;
+    int m_Width = 0;
+    int m_Height = 0;
+    int m_ViewportWidth = 0;
+    int m_ViewportHeight = 0;
+    float m_Scale = 1.0f;
+    std::string m_Name = "Render target";
+
+    // enables every colour attachment of the currently bound framebuffer
+    void setDrawBuffers() const {
+        std::vector<GLenum> drawBuffers;
+        for (unsigned int i = 0; i < m_Attachments.size(); ++i) {
+            drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+        }
+        glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+    }
+
+    void release() {
+        MemoryTracker& tracker = memoryTracker();
+        for (ColorAttachment& attachment : m_Attachments) {
+            glDeleteTextures(1, &attachment.texture);
+            glState().textureDeleted(attachment.texture);
+            tracker.textureDeleted(attachment.texture);
+            attachment.texture = 0;
+        }
+        if (!m_ColorRenderbuffers.empty()) {
+            glDeleteRenderbuffers(m_ColorRenderbuffers.size(), m_ColorRenderbuffers.data());
+            for (unsigned int renderbuffer : m_ColorRenderbuffers) {
+                tracker.renderbufferDeleted(renderbuffer);
+            }
+            m_ColorRenderbuffers.clear();
+        }
+        glDeleteRenderbuffers(1, &m_DepthStencil);
+        tracker.renderbufferDeleted(m_DepthStencil);
+        glDeleteFramebuffers(1, &m_Fbo);
+        glState().framebufferDeleted(m_Fbo);
+        m_DepthStencil = 0;
+        m_AttachedDepthStencil = 0;
+        m_Fbo = 0;
+    }
+
+    void allocate() {
+        release();
+        GLState& state = glState();
+        glGenFramebuffers(1, &m_Fbo);
+        state.bindFramebuffer(GL_FRAMEBUFFER, m_Fbo);
+
+        for (unsigned int i = 0; i < m_Attachments.size(); ++i) {
+            ColorAttachment& attachment = m_Attachments[i];
+            if (m_Samples > 1) {
+                unsigned int renderbuffer;
+                glGenRenderbuffers(1, &renderbuffer);
+                glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+                glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_Samples, attachment.internalFormat,
+                                                 m_Width, m_Height);
+                memoryTracker().renderbufferAllocated(renderbuffer, attachment.internalFormat, m_Width, m_Height,
+                                                      m_Samples, MemoryCategory::RenderTarget, m_Name.c_str());
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+                                          GL_RENDERBUFFER, renderbuffer);
+                m_ColorRenderbuffers.push_back(renderbuffer);
+                continue;
+            }
+            glGenTextures(1, &attachment.texture);
+            state.bindTexture(0, GL_TEXTURE_2D, attachment.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, attachment.internalFormat, m_Width, m_Height, 0,
+                         attachment.format, attachment.type, nullptr);
+            memoryTracker().textureLevelAllocated(attachment.texture, GL_TEXTURE_2D, 0, attachment.internalFormat,
+                                                  m_Width, m_Height, 0, MemoryCategory::RenderTarget,
+                                                  m_Name.c_str());
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, attachment.filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, attachment.filter);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // Prevents edge bleeding
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // Prevents edge bleeding
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D,
+                                   attachment.texture, 0);
+        }
+        setDrawBuffers();
+
+        if (m_HasDepthStencil) {
+            glGenRenderbuffers(1, &m_DepthStencil);
+            glBindRenderbuffer(GL_RENDERBUFFER, m_DepthStencil);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_Samples > 1 ? m_Samples : 0,
+                                             GL_DEPTH24_STENCIL8, m_Width, m_Height);
+            memoryTracker().renderbufferAllocated(m_DepthStencil, GL_DEPTH24_STENCIL8, m_Width, m_Height, m_Samples,
+                                                  MemoryCategory::RenderTarget, m_Name.c_str());
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                                      GL_RENDERBUFFER, m_DepthStencil);
+        }
+
+        auto fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Framebuffer error: " << fboStatus << std::endl;
+        }
+        state.bindTexture(0, GL_TEXTURE_2D, 0);
+        state.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_RENDERTARGET_H
@@ -0,0 +1,99 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_SELECTIONOUTLINE_H
+#define PROJECT_BASE_SELECTIONOUTLINE_H
+
+#include <glm/glm.hpp>
+#include <rg/GLState.h>
+#include <rg/RenderTarget.h>
+#include <vector>
+
+namespace rg {
+
+// Screen-space outline around every selected object, drawn from a mask instead
+// of re-rendering the objects. Selected objects write a stencil reference
+// where they are visible; the outline pass
+//   1. seeds: writes its own position into each masked pixel (stencil test
+//      against the scene's depth-stencil buffer),
+//   2. jump floods: log2(Width) + 1 passes that leave in every pixel the
+//      position of the nearest seed within Width pixels,
+//   3. composites Color over the scene where that distance is between 0 and
+//      Width.
+// The cost depends on the resolution and Width only, not on how many objects
+// are selected or how many vertices they have.
+class SelectionOutline {
+public:
+    // thickness in pixels of the render resolution
+    int Width = 3;
+    glm::vec3 Color = glm::vec3(1.0f);
+
+    SelectionOutline()
+        : m_Targets{RenderTarget({{GL_RG32F, GL_RG, GL_FLOAT, GL_NEAREST}}, false),
+                    RenderTarget({{GL_RG32F, GL_RG, GL_FLOAT, GL_NEAREST}}, false)} {
+        m_Targets[0].setName("Selection outline");
+        m_Targets[1].setName("Selection outline");
+    }
+
+    // Follows the size and scale of the single sampled scene target, whose
+    // stencil holds the selection mask. Cheap when nothing changed.
+    void prepare(const RenderTarget& scene) {
+        for (RenderTarget& target : m_Targets) {
+            target.resize(scene.width(), scene.height());
+            target.setScale(scene.scale());
+        }
+        m_Targets[0].attachDepthStencil(&scene);
+    }
+
+    // Clears both targets to "no seed" (negative coordinates) and binds the
+    // first one, which shares the scene's stencil buffer, for the seed pass.
+    void beginSeeds() {
+        static const float noSeed[4] = {-1.0f, -1.0f, 0.0f, 0.0f};
+        m_Targets[1].bind();
+        glClearBufferfv(GL_COLOR, 0, noSeed);
+        m_Targets[0].bind();
+        glClearBufferfv(GL_COLOR, 0, noSeed);
+        m_Current = 0;
+    }
+
+    // Step sizes of the flood passes, largest first.
+    std::vector<int> floodSteps() const {
+        std::vector<int> steps;
+        int step = 1;
+        while (step * 2 <= Width) {
+            step *= 2;
+        }
+        for (; step >= 1; step /= 2) {
+            steps.push_back(step);
+        }
+        return steps;
+    }
+
+    // Binds the other target for the next flood pass and returns the texture
+    // with the previous pass's result to read from.
+    unsigned int beginFloodPass() {
+        unsigned int previous = m_Targets[m_Current].colorTexture();
+        m_Current = 1 - m_Current;
+        m_Targets[m_Current].bind();
+        return previous;
+    }
+
+    // nearest seed of each pixel once the flood passes are done
+    unsigned int result() const {
+        return m_Targets[m_Current].colorTexture();
+    }
+
+    void destroy() {
+        m_Targets[0].destroy();
+        m_Targets[1].destroy();
+    }
+
+private:
+    RenderTarget m_Targets[2];
+    int m_Current = 0;
+};
+
+};
+
+#endif //PROJECT_BASE_SELECTIONOUTLINE_H
@@ -0,0 +1,80 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_SHADERCACHE_H
+#define PROJECT_BASE_SHADERCACHE_H
+
+#include <learnopengl/shader.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+
+namespace rg {
+
+// Optional parts of a shader, one bit each of a permutation key. Every bit
+// set turns into a #define of the same name, so code for features that are
+// off is removed by the preprocessor rather than branched over at run time.
+enum ShaderFeature : unsigned int {
+    // surface normals from the normal map instead of the vertex normal
+    HAS_NORMAL_MAP = 1u << 0,
+    // specular strength from the specular map instead of the material colour
+    HAS_SPECULAR_MAP = 1u << 1,
+    // depth fog towards grey
+    FOG = 1u << 2,
+    // diffuse colour from the diffuse map instead of the material colour
+    HAS_DIFFUSE_MAP = 1u << 3,
+};
+
+// the #define lines a permutation key is compiled with
+inline std::string shaderDefines(unsigned int features) {
+    static const std::pair<ShaderFeature, const char*> names[] = {
+        {HAS_NORMAL_MAP, "HAS_NORMAL_MAP"},
+        {HAS_SPECULAR_MAP, "HAS_SPECULAR_MAP"},
+        {FOG, "FOG"},
+        {HAS_DIFFUSE_MAP, "HAS_DIFFUSE_MAP"},
+    };
+    std::string defines;
+    for (const auto& name : names) {
+        if (features & name.first) {
+            defines += std::string("#define ") + name.second + "\n";
+        }
+    }
+    return defines;
+}
+
+// Compiled permutations by vertex shader, fragment shader and feature key.
+// Asking twice for the same permutation returns the program compiled the
+// first time, so passes that draw with the same shader share one program.
+//
+//   Shader& shader = cache.get("resources/shaders/lit.vs", "resources/shaders/lit.fs", FOG | HAS_NORMAL_MAP);
+class ShaderCache {
+public:
+    // created is set to whether the permutation had to be compiled
+    Shader& get(const std::string& vertexPath, const std::string& fragmentPath, unsigned int features,
+                bool* created = nullptr) {
+        std::unique_ptr<Shader>& shader = m_Shaders[Key(vertexPath, fragmentPath, features)];
+        if (created) {
+            *created = !shader;
+        }
+        if (!shader) {
+            shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, shaderDefines(features)));
+        }
+        return *shader;
+    }
+
+    size_t size() const {
+        return m_Shaders.size();
+    }
+
+private:
+    using Key = std::tuple<std::string, std::string, unsigned int>;
+
+    // Shader addresses stay valid as the map grows
+    std::map<Key, std::unique_ptr<Shader>> m_Shaders;
+};
+
+};
+
+#endif //PROJECT_BASE_SHADERCACHE_H
@@ -0,0 +1,115 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_SHADERRELOADER_H
+#define PROJECT_BASE_SHADERRELOADER_H
+
+#include <learnopengl/shader.h>
+#include <rg/FileWatcher.h>
+#include <rg/Profiler.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace rg {
+
+// Rebuilds shaders whose source files change while the app runs, so shader
+// work does not need a restart and a reload of every model.
+//
+// Changed programs are compiled next to the ones in use and swapped in
+// together, between two frames, once all of them have finished; one edit to
+// a shared vertex shader never leaves half the passes on the old version. A
+// program that fails to compile or link is reported and the old one stays.
+//
+//   reloader.add(framebufferShader, [&] {
+//       framebufferShader.use();
+//       framebufferShader.setInt("screenTexture", 0);
+//   });
+//   ...
+//   reloader.update();   // GL thread, before the frame records or draws
+class ShaderReloader {
+public:
+    // Watches the sources of shader. setup restores what lives in the program
+    // object and is not set every frame (sampler units, block bindings); it
+    // runs right away and again after every rebuild.
+    void add(Shader& shader, std::function<void()> setup = nullptr) {
+        for (const std::string& path : shader.sources()) {
+            m_Watcher.watch(path);
+        }
+        if (setup) {
+            setup();
+        }
+        m_Entries.push_back({&shader, std::move(setup)});
+    }
+
+    // Starts rebuilding the shaders with changed sources and swaps in the
+    // rebuilt ones once none is still compiling. Returns the number of
+    // programs swapped in; their IDs have changed.
+    int update() {
+        std::vector<std::string> changed = m_Watcher.changes();
+        if (!changed.empty()) {
+            PROFILE_CPU_SCOPE("Shader reload");
+            for (Entry& entry : m_Entries) {
+                std::vector<std::string> sources = entry.shader->sources();
+                bool affected = std::any_of(sources.begin(), sources.end(), [&](const std::string& path) {
+                    return std::find(changed.begin(), changed.end(), path) != changed.end();
+                });
+                if (affected) {
+                    entry.shader->beginReload();
+                }
+            }
+        }
+
+        bool reloading = false;
+        for (Entry& entry : m_Entries) {
+            if (entry.shader->reloading()) {
+                if (!entry.shader->reloadReady()) {
+                    return 0;
+                }
+                reloading = true;
+            }
+        }
+        if (!reloading) {
+            return 0;
+        }
+
+        int swapped = 0;
+        for (Entry& entry : m_Entries) {
+            if (!entry.shader->reloading()) {
+                continue;
+            }
+            if (entry.shader->finishReload()) {
+                // the edit may have added an #include
+                for (const std::string& path : entry.shader->sources()) {
+                    m_Watcher.watch(path);
+                }
+                if (entry.setup) {
+                    entry.setup();
+                }
+                ++swapped;
+            } else {
+                std::cout << "Shader reload failed, keeping the previous program" << std::endl;
+            }
+        }
+        if (swapped > 0) {
+            std::cout << "Reloaded " << swapped << " shader program(s)" << std::endl;
+        }
+        return swapped;
+    }
+
+private:
+    struct Entry {
+        Shader* shader;
+        std::function<void()> setup;
+    };
+
+    FileWatcher m_Watcher;
+    std::vector<Entry> m_Entries;
+};
+
+};
+
+#endif //PROJECT_BASE_SHADERRELOADER_H
@@ -0,0 +1,104 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_TEMPORALAA_H
+#define PROJECT_BASE_TEMPORALAA_H
+
+#include <glm/glm.hpp>
+#include <rg/RenderTarget.h>
+
+namespace rg {
+
+// State of the temporal reconstruction pass: the sub-pixel jitter sequence and the
+// two native resolution history buffers that are ping-ponged every frame.
+// The scene is rendered with a jittered projection at whatever scale the dynamic
+// resolution controller picked; the resolve pass accumulates those samples into
+// the history at window resolution.
+class TemporalAA {
+public:
+    static const int kJitterPhases = 8;
+
+    bool Enabled = true;
+    // weight of the reprojected history in the resolved colour
+    float Feedback = 0.9f;
+
+    TemporalAA()
+        : m_History{RenderTarget({{GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR}}, false),
+                    RenderTarget({{GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_LINEAR}}, false)} {
+        m_History[0].setName("TAA history");
+        m_History[1].setName("TAA history");
+    }
+
+    void resize(int width, int height) {
+        bool reallocated = m_History[0].resize(width, height);
+        reallocated |= m_History[1].resize(width, height);
+        if (reallocated) {
+            m_HistoryValid = false;
+        }
+    }
+
+    // Offset in NDC for this frame's projection, a Halton(2, 3) point inside one
+    // pixel of the render resolution.
+    glm::vec2 nextJitter(int renderWidth, int renderHeight) {
+        m_Phase = (m_Phase + 1) % kJitterPhases;
+        glm::vec2 sample(halton(m_Phase + 1, 2) - 0.5f, halton(m_Phase + 1, 3) - 0.5f);
+        return glm::vec2(2.0f * sample.x / renderWidth, 2.0f * sample.y / renderHeight);
+    }
+
+    // Shifts a perspective projection by jitter NDC units after the perspective divide.
+    static glm::mat4 jitterProjection(glm::mat4 projection, glm::vec2 jitter) {
+        // clip.w = -z_view, so adding jitter * w means subtracting jitter * z_view
+        projection[2][0] -= jitter.x;
+        projection[2][1] -= jitter.y;
+        return projection;
+    }
+
+    RenderTarget& output() {
+        return m_History[m_Current];
+    }
+
+    const RenderTarget& history() const {
+        return m_History[1 - m_Current];
+    }
+
+    bool historyValid() const {
+        return m_HistoryValid;
+    }
+
+    void invalidate() {
+        m_HistoryValid = false;
+    }
+
+    // Call after the resolve: this frame's output becomes next frame's history.
+    void swap() {
+        m_Current = 1 - m_Current;
+        m_HistoryValid = true;
+    }
+
+    void destroy() {
+        m_History[0].destroy();
+        m_History[1].destroy();
+    }
+
+private:
+    RenderTarget m_History[2];
+    int m_Current = 0;
+    int m_Phase = 0;
+    bool m_HistoryValid = false;
+
+    static float halton(int index, int base) {
+        float f = 1.0f;
+        float result = 0.0f;
+        while (index > 0) {
+            f /= base;
+            result += f * (index % base);
+            index /= base;
+        }
+        return result;
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_TEMPORALAA_H
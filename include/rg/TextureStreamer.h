@@ -0,0 +1,368 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_TEXTURESTREAMER_H
+#define PROJECT_BASE_TEXTURESTREAMER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <rg/CookedAssets.h>
+#include <rg/GLState.h>
+#include <rg/JobSystem.h>
+#include <rg/MemoryTracker.h>
+#include <rg/Profiler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rg {
+
+struct TextureStreamingStats {
+    size_t Textures = 0;
+    // bytes of the levels on the GPU and of every level of every texture
+    size_t ResidentBytes = 0;
+    size_t FullBytes = 0;
+    size_t Budget = 0;
+    size_t LoadsInFlight = 0;
+    // levels streamed in and dropped since the start
+    size_t LevelsLoaded = 0;
+    size_t LevelsEvicted = 0;
+};
+
+// Keeps the mip levels of cooked textures on the GPU only as far as the
+// screen needs them. A texture starts with its tail, the levels up to
+// kTailSize texels across. Every frame the renderer reports how densely each
+// texture is sampled on screen; the streamer turns that into the finest level
+// the texture needs and loads the levels above what it has, one at a time and
+// coarse to fine, while the resident levels of all textures fit the budget.
+// When they would not, textures holding finer levels than they need give
+// theirs up. Tails always stay.
+//
+// GL 3.3 has no sparse or immutable textures, so the resident range is kept
+// with GL_TEXTURE_BASE_LEVEL: a level is specified first and the base level
+// moved onto it, and an evicted level gets the base level moved past it first
+// and is then respecified with zero size, which frees its storage. Sampling
+// never sees an incomplete texture.
+//
+// Loads are asynchronous: the GL thread maps a pixel unpack buffer, a job
+// copies the level from the mapped package into it, which is where the disk
+// read happens, and a later update() unmaps it and specifies the level from
+// it without waiting for the transfer.
+//
+// add(), forget(), update() and destroy() are for the GL thread. use() may be
+// called from the jobs recording a frame, as long as nothing is added or
+// forgotten while they run.
+//
+//   rg::textureStreamer().beginFrame(camera.Position, glm::radians(camera.Zoom), viewportHeight);
+//   // record, for every map of every drawn mesh:
+//   rg::textureStreamer().use(map, rg::textureStreamer().uvPerPixel(center, radius, uvDensity));
+//   rg::textureStreamer().update();
+class TextureStreamer {
+public:
+    // levels this many texels across or less are always resident
+    static const uint32_t kTailSize = 64;
+    // levels in flight at once, each in a pixel unpack buffer of its own
+    static const size_t kMaxLoads = 4;
+    // frames a texture keeps its target level after it was last used
+    static const uint64_t kKeepFrames = 120;
+
+    // when off, add() is never called and cooked textures load whole
+    bool Enabled = true;
+
+    // bytes the resident levels may take, tails included
+    void setBudget(size_t bytes) {
+        m_Budget = bytes;
+    }
+
+    size_t budget() const {
+        return m_Budget;
+    }
+
+    // Streams the texture bound to GL_TEXTURE_2D of unit 0, id, from
+    // texture: uploads its tail and clamps sampling to it.
+    void add(GLuint id, const CookedTexture& texture) {
+        std::unique_ptr<Entry> entry(new Entry(id, texture));
+        const CookedTextureHeader& h = texture.header();
+        entry->Tail = h.Levels - 1;
+        while (entry->Tail > 0 &&
+               std::max(texture.level(entry->Tail - 1).Width, texture.level(entry->Tail - 1).Height) <= kTailSize) {
+            entry->Tail--;
+        }
+        entry->Resident = entry->Target = entry->Tail;
+        texture.uploadRange(GL_TEXTURE_2D, entry->Tail, h.Levels);
+        texture.track(id, GL_TEXTURE_2D, entry->Tail, h.Levels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry->Tail);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, h.Levels - 1);
+        m_Resident += entry->bytes(entry->Tail, h.Levels);
+        m_Full += entry->bytes(0, h.Levels);
+        m_Lookup[id] = entry.get();
+        m_Entries.push_back(std::move(entry));
+    }
+
+    // Stops streaming id, before the texture is deleted.
+    void forget(GLuint id) {
+        auto found = m_Lookup.find(id);
+        if (found == m_Lookup.end()) {
+            return;
+        }
+        Entry* entry = found->second;
+        if (entry->Unpack) {
+            finishLoad(*entry, false);
+        }
+        const uint32_t levels = entry->Texture.header().Levels;
+        m_Resident -= entry->bytes(entry->Resident, levels);
+        m_Full -= entry->bytes(0, levels);
+        m_Lookup.erase(found);
+        m_Entries.erase(std::find_if(m_Entries.begin(), m_Entries.end(), [entry](const std::unique_ptr<Entry>& e) {
+            return e.get() == entry;
+        }));
+    }
+
+    // the camera footprints are measured from in this frame, fovY in radians
+    void beginFrame(const glm::vec3& viewPosition, float fovY, float viewportHeight) {
+        m_ViewPosition = viewPosition;
+        m_WorldPerPixel = 2.0f * std::tan(fovY * 0.5f) / std::max(viewportHeight, 1.0f);
+    }
+
+    // Texture coordinate units per pixel on a surface within radius of
+    // center, in world space, with uvDensity texture coordinate units per
+    // world unit; taken where the surface may come closest to the camera.
+    float uvPerPixel(const glm::vec3& center, float radius, float uvDensity) const {
+        float distance = std::max(glm::length(center - m_ViewPosition) - radius, float(kNear));
+        return uvDensity * distance * m_WorldPerPixel;
+    }
+
+    // Notes that texture is drawn at uvPerPixel (see above) this frame.
+    // Textures that are not streamed are ignored.
+    void use(GLuint texture, float uvPerPixel) {
+        auto found = m_Lookup.find(texture);
+        if (found == m_Lookup.end() || uvPerPixel <= 0.0f) {
+            return;
+        }
+        Entry& entry = *found->second;
+        // one texel per pixel at the finest level that is not larger than
+        // the footprint
+        const CookedTextureHeader& h = entry.Texture.header();
+        float texelsPerPixel = uvPerPixel * (float) std::max(h.Width, h.Height);
+        float level = std::floor(std::log2(std::max(texelsPerPixel, 1.0f)));
+        uint32_t wanted = (uint32_t) std::min(level, (float) (h.Levels - 1));
+        uint32_t current = entry.Wanted.load(std::memory_order_relaxed);
+        while (wanted < current && !entry.Wanted.compare_exchange_weak(current, wanted, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Finishes the loads whose data has arrived, then starts loads and
+    // evicts levels by what the frame asked for.
+    void update() {
+        PROFILE_CPU_SCOPE("Texture streaming");
+        m_Frame++;
+        for (const std::unique_ptr<Entry>& entry : m_Entries) {
+            if (entry->Unpack && entry->Copy.done()) {
+                finishLoad(*entry, true);
+            }
+            uint32_t wanted = entry->Wanted.exchange(~0u, std::memory_order_relaxed);
+            if (wanted != ~0u) {
+                entry->LastUsed = m_Frame;
+                entry->Target = std::min(wanted, entry->Tail);
+            } else if (m_Frame - entry->LastUsed > kKeepFrames) {
+                entry->Target = entry->Tail;
+            }
+        }
+
+        // over the budget, a lowered one say: drop what is not needed
+        while (m_Resident + m_Loading > m_Budget && evictOne()) {
+        }
+
+        // the textures furthest from their target level first
+        std::vector<Entry*> wanting;
+        for (const std::unique_ptr<Entry>& entry : m_Entries) {
+            if (entry->Target < entry->Resident && !entry->Unpack) {
+                wanting.push_back(entry.get());
+            }
+        }
+        std::sort(wanting.begin(), wanting.end(), [](const Entry* a, const Entry* b) {
+            return a->Resident - a->Target > b->Resident - b->Target;
+        });
+        for (Entry* entry : wanting) {
+            if (m_LoadsInFlight >= kMaxLoads) {
+                break;
+            }
+            size_t size = entry->bytes(entry->Resident - 1, entry->Resident);
+            while (m_Resident + m_Loading + size > m_Budget && evictOne()) {
+            }
+            if (m_Resident + m_Loading + size > m_Budget) {
+                break;
+            }
+            startLoad(*entry);
+        }
+    }
+
+    TextureStreamingStats stats() const {
+        TextureStreamingStats stats;
+        stats.Textures = m_Entries.size();
+        stats.ResidentBytes = m_Resident;
+        stats.FullBytes = m_Full;
+        stats.Budget = m_Budget;
+        stats.LoadsInFlight = m_LoadsInFlight;
+        stats.LevelsLoaded = m_LevelsLoaded;
+        stats.LevelsEvicted = m_LevelsEvicted;
+        return stats;
+    }
+
+    // Waits for the loads in flight and forgets every texture; the textures
+    // themselves belong to their models.
+    void destroy() {
+        for (const std::unique_ptr<Entry>& entry : m_Entries) {
+            if (entry->Unpack) {
+                finishLoad(*entry, false);
+            }
+        }
+        m_Entries.clear();
+        m_Lookup.clear();
+        m_Resident = m_Full = 0;
+    }
+
+private:
+    struct Entry {
+        Entry(GLuint id, const CookedTexture& texture) : Id(id), Texture(texture) {
+        }
+
+        GLuint Id;
+        CookedTexture Texture;
+        // first level that always stays
+        uint32_t Tail = 0;
+        // first resident level, GL_TEXTURE_BASE_LEVEL
+        uint32_t Resident = 0;
+        // the finest level needed
+        uint32_t Target = 0;
+        // finest level asked for by use() this frame
+        std::atomic<uint32_t> Wanted{~0u};
+        uint64_t LastUsed = 0;
+        // load in flight: Resident - 1 into Unpack, copied by a job
+        GLuint Unpack = 0;
+        JobCounter Copy;
+
+        size_t bytes(uint32_t first, uint32_t end) const {
+            size_t total = 0;
+            for (uint32_t i = first; i < end; i++) {
+                total += Texture.level(i).Size;
+            }
+            return total;
+        }
+    };
+
+    // closest distance a footprint is measured at
+    static constexpr float kNear = 0.1f;
+
+    std::vector<std::unique_ptr<Entry>> m_Entries;
+    std::unordered_map<GLuint, Entry*> m_Lookup;
+    size_t m_Budget = 256u << 20;
+    size_t m_Resident = 0;
+    size_t m_Full = 0;
+    // bytes of the levels in flight
+    size_t m_Loading = 0;
+    size_t m_LoadsInFlight = 0;
+    size_t m_LevelsLoaded = 0;
+    size_t m_LevelsEvicted = 0;
+    uint64_t m_Frame = 0;
+    glm::vec3 m_ViewPosition = glm::vec3(0.0f);
+    float m_WorldPerPixel = 0.0f;
+
+    void startLoad(Entry& entry) {
+        uint32_t level = entry.Resident - 1;
+        size_t size = entry.bytes(level, level + 1);
+        glGenBuffers(1, &entry.Unpack);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, entry.Unpack);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        memoryTracker().bufferAllocated(entry.Unpack, size, GL_STREAM_DRAW, MemoryCategory::Staging,
+                                        "Texture streaming");
+        void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!destination) {
+            glDeleteBuffers(1, &entry.Unpack);
+            memoryTracker().bufferDeleted(entry.Unpack);
+            entry.Unpack = 0;
+            return;
+        }
+        const unsigned char* source = entry.Texture.levelData(level);
+        jobs().run("Stream texture level", [destination, source, size] {
+            std::memcpy(destination, source, size);
+        }, &entry.Copy);
+        m_Loading += size;
+        m_LoadsInFlight++;
+    }
+
+    // Specifies the level in flight from its buffer, or with apply false just
+    // lets the buffer go.
+    void finishLoad(Entry& entry, bool apply) {
+        jobs().wait(entry.Copy);
+        uint32_t level = entry.Resident - 1;
+        size_t size = entry.bytes(level, level + 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, entry.Unpack);
+        // false when the buffer lost its contents, the level is tried again
+        bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        if (apply && intact) {
+            glState().bindTexture(0, GL_TEXTURE_2D, entry.Id);
+            entry.Texture.specify(GL_TEXTURE_2D, level, nullptr);
+            entry.Texture.track(entry.Id, GL_TEXTURE_2D, level, level + 1);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            entry.Resident = level;
+            m_Resident += size;
+            m_LevelsLoaded++;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        // the driver keeps the storage until the upload has read it
+        glDeleteBuffers(1, &entry.Unpack);
+        memoryTracker().bufferDeleted(entry.Unpack);
+        entry.Unpack = 0;
+        m_Loading -= size;
+        m_LoadsInFlight--;
+    }
+
+    // Drops the finest level of the texture that has the most levels beyond
+    // its target, least recently used first; false when none has any.
+    bool evictOne() {
+        Entry* victim = nullptr;
+        for (const std::unique_ptr<Entry>& entry : m_Entries) {
+            if (entry->Resident >= entry->Target || entry->Unpack) {
+                continue;
+            }
+            if (!victim || entry->Target - entry->Resident > victim->Target - victim->Resident ||
+                (entry->Target - entry->Resident == victim->Target - victim->Resident &&
+                 entry->LastUsed < victim->LastUsed)) {
+                victim = entry.get();
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+        uint32_t level = victim->Resident;
+        glState().bindTexture(0, GL_TEXTURE_2D, victim->Id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+        victim->Texture.release(GL_TEXTURE_2D, level);
+        memoryTracker().textureLevelReleased(victim->Id, GL_TEXTURE_2D, level);
+        victim->Resident = level + 1;
+        m_Resident -= victim->bytes(level, level + 1);
+        m_LevelsEvicted++;
+        return true;
+    }
+};
+
+// the streamer of the textures of cooked models
+inline TextureStreamer& textureStreamer() {
+    static TextureStreamer instance;
+    return instance;
+}
+
+};
+
+#endif //PROJECT_BASE_TEXTURESTREAMER_H
@@ -0,0 +1,113 @@
+//
+// Created by matf-rg on 19.10.26..
+//
+
+#ifndef PROJECT_BASE_WEIGHTEDBLENDEDOIT_H
+#define PROJECT_BASE_WEIGHTEDBLENDEDOIT_H
+
+#include <rg/GLState.h>
+#include <rg/RenderTarget.h>
+
+namespace rg {
+
+// Weighted blended order-independent transparency (McGuire and Bavoil, 2013).
+// Transparent surfaces are not sorted: each fragment adds its premultiplied
+// colour, scaled by a depth and coverage based weight, into an accumulation
+// target, and a full screen composite divides by the summed weights and blends
+// the average over the opaque scene by the total coverage. Cost is one
+// additive draw per surface plus the composite, whatever the order.
+//
+// GL 3.3 has a single blend function for all draw buffers, so the two targets
+// are laid out to need only one: colour channels add up and alpha channels
+// multiply.
+//   0: RGBA16F  rgb = sum(color * alpha * weight), a = revealage, the product
+//               of (1 - alpha), cleared to 1
+//   1: R16F     r = sum(alpha * weight)
+//
+// The targets share the depth-stencil buffer of the scene target, so
+// transparent surfaces are depth tested against the opaque ones without
+// writing depth. With MSAA they are multisampled like the scene and resolved
+// before the composite.
+class WeightedBlendedOIT {
+public:
+    WeightedBlendedOIT()
+        : m_Target({{GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_NEAREST}, {GL_R16F, GL_RED, GL_FLOAT, GL_NEAREST}}, false)
+        , m_MsaaTarget({{GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_NEAREST}, {GL_R16F, GL_RED, GL_FLOAT, GL_NEAREST}}, false,
+                       4) {
+        m_Target.setName("Transparency accumulation");
+        m_MsaaTarget.setName("Transparency accumulation (MSAA)");
+    }
+
+    // Follows the size, scale and sample count of the target the opaque scene
+    // is rendered into. Cheap when nothing changed.
+    void prepare(const RenderTarget& scene) {
+        m_Scene = &scene;
+        m_Target.resize(scene.width(), scene.height());
+        m_Target.setScale(scene.scale());
+        if (scene.samples() > 1) {
+            m_MsaaTarget.resize(scene.width(), scene.height());
+            m_MsaaTarget.setScale(scene.scale());
+            m_MsaaTarget.attachDepthStencil(&scene);
+            m_Target.attachDepthStencil(nullptr);
+        } else {
+            if (m_MsaaTarget.width() > 0) {
+                m_MsaaTarget.destroy();
+            }
+            m_Target.attachDepthStencil(&scene);
+        }
+    }
+
+    // Binds and clears the accumulation targets and sets up blending; the
+    // transparent draws follow, with depth testing on.
+    void beginAccumulate() {
+        accumulationTarget().bind();
+        static const float accumulationClear[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        static const float weightClear[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        glClearBufferfv(GL_COLOR, 0, accumulationClear);
+        glClearBufferfv(GL_COLOR, 1, weightClear);
+        GLState& state = glState();
+        state.enable(GL_BLEND);
+        state.blendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        state.depthMask(false);
+    }
+
+    // Restores depth writes and the regular blend function, resolves the MSAA
+    // targets and binds the scene target again for the composite.
+    void endAccumulate() {
+        GLState& state = glState();
+        state.depthMask(true);
+        state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.disable(GL_BLEND);
+        if (m_Scene->samples() > 1) {
+            m_MsaaTarget.resolveTo(m_Target);
+        }
+        m_Scene->bind();
+    }
+
+    // what the composite pass reads, texel for texel with the scene viewport
+    unsigned int accumulationTexture() const {
+        return m_Target.colorTexture(0);
+    }
+
+    unsigned int weightTexture() const {
+        return m_Target.colorTexture(1);
+    }
+
+    void destroy() {
+        m_Target.destroy();
+        m_MsaaTarget.destroy();
+    }
+
+private:
+    RenderTarget m_Target;
+    RenderTarget m_MsaaTarget;
+    const RenderTarget* m_Scene = nullptr;
+
+    RenderTarget& accumulationTarget() {
+        return m_Scene->samples() > 1 ? m_MsaaTarget : m_Target;
+    }
+};
+
+};
+
+#endif //PROJECT_BASE_WEIGHTEDBLENDEDOIT_H
@@ -1,7 +0,0 @@
-#version 330 core
-
-out vec4 FragColor;
-
-void main() {
-    FragColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);
-}
\ No newline at end of file
@@ -8,6 +8,7 @@ uniform sampler2D screenTexture;
 const float offset_x = 1.0f / 800.0f;  
 const float offset_y = 1.0f / 800.0f;  
 uniform float gamma;
+uniform vec2 uvScale;
 
 vec2 offsets[9] = vec2[]
 (
@@ -26,8 +27,11 @@ float kernel[9] = float[]
 void main()
 {
     vec3 color = vec3(0.0f);
+    // keep the kernel the same size relative to the image and never sample outside
+    // the rendered sub-rectangle of the scene texture
+    vec2 texel = 0.5f / vec2(textureSize(screenTexture, 0));
     for(int i = 0; i < 9; i++)
-        color += vec3(texture(screenTexture, texCoords.st + offsets[i])) * kernel[i];
+        color += vec3(texture(screenTexture, clamp(texCoords.st + offsets[i] * uvScale, texel, uvScale - texel))) * kernel[i];
     FragColor = vec4(color, 1.0f);
 
     float exposure = 0.5f;
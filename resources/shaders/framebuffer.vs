@@ -5,8 +5,11 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 texCoords;
 
+// fraction of the scene texture that was actually rendered this frame
+uniform vec2 uvScale;
+
 void main()
 {
     gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0); 
-    texCoords = aTexCoords;
+    texCoords = aTexCoords * uvScale;
 }  
\ No newline at end of file
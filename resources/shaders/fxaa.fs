@@ -0,0 +1,65 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 texCoords;
+
+// tonemapped, gamma corrected output of the framebuffer pass
+uniform sampler2D screenTexture;
+
+// FXAA (console quality class): one pass, at most 9 taps per pixel.
+// Edges are found from luma contrast in a 2x2 diagonal neighbourhood, the blur is
+// taken along the edge direction and rejected if it leaves the local luma range.
+#define FXAA_EDGE_THRESHOLD     (1.0f / 8.0f)
+#define FXAA_EDGE_THRESHOLD_MIN (1.0f / 24.0f)
+#define FXAA_REDUCE_MUL         (1.0f / 8.0f)
+#define FXAA_REDUCE_MIN         (1.0f / 128.0f)
+#define FXAA_SPAN_MAX           8.0f
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.299f, 0.587f, 0.114f));
+}
+
+void main()
+{
+    vec2 texel = 1.0f / vec2(textureSize(screenTexture, 0));
+
+    vec3 rgbM  = texture(screenTexture, texCoords).rgb;
+    vec3 rgbNW = texture(screenTexture, texCoords + vec2(-1.0f,  1.0f) * texel).rgb;
+    vec3 rgbNE = texture(screenTexture, texCoords + vec2( 1.0f,  1.0f) * texel).rgb;
+    vec3 rgbSW = texture(screenTexture, texCoords + vec2(-1.0f, -1.0f) * texel).rgb;
+    vec3 rgbSE = texture(screenTexture, texCoords + vec2( 1.0f, -1.0f) * texel).rgb;
+
+    float lumaM  = luma(rgbM);
+    float lumaNW = luma(rgbNW);
+    float lumaNE = luma(rgbNE);
+    float lumaSW = luma(rgbSW);
+    float lumaSE = luma(rgbSE);
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // flat areas are left alone, this is where most pixels exit
+    if (lumaMax - lumaMin < max(FXAA_EDGE_THRESHOLD_MIN, lumaMax * FXAA_EDGE_THRESHOLD)) {
+        FragColor = vec4(rgbM, 1.0f);
+        return;
+    }
+
+    vec2 dir;
+    dir.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));
+    dir.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));
+
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25f * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0f / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel;
+
+    vec3 rgbA = 0.5f * (texture(screenTexture, texCoords + dir * (1.0f / 3.0f - 0.5f)).rgb +
+                        texture(screenTexture, texCoords + dir * (2.0f / 3.0f - 0.5f)).rgb);
+    vec3 rgbB = rgbA * 0.5f + 0.25f * (texture(screenTexture, texCoords + dir * -0.5f).rgb +
+                                       texture(screenTexture, texCoords + dir * 0.5f).rgb);
+
+    float lumaB = luma(rgbB);
+    if (lumaB < lumaMin || lumaB > lumaMax)
+        FragColor = vec4(rgbA, 1.0f);
+    else
+        FragColor = vec4(rgbB, 1.0f);
+}
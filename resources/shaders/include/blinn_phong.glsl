@@ -0,0 +1,88 @@
+// Blinn-Phong lighting from one point light. Samplers exist only for the maps
+// the permutation was compiled with (HAS_DIFFUSE_MAP, HAS_SPECULAR_MAP,
+// HAS_NORMAL_MAP); the material colours stand in for the missing ones.
+
+struct PointLight {
+    vec3 position;
+
+    vec3 specular;
+    vec3 diffuse;
+    vec3 ambient;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// parameters of the bound material (rg::MaterialParams, same order)
+layout (std140) uniform MaterialParams {
+    vec3 diffuseColor;
+    float shininess;
+    vec3 specularColor;
+};
+
+// on the units of rg::Material
+#ifdef HAS_DIFFUSE_MAP
+uniform sampler2D diffuseMap;
+#endif
+#ifdef HAS_SPECULAR_MAP
+uniform sampler2D specularMap;
+#endif
+#ifdef HAS_NORMAL_MAP
+uniform sampler2D normalMap;
+#endif
+
+uniform PointLight pointLight;
+
+// the normal map holds world space normals
+vec3 surfaceNormal(vec3 normal, vec2 texCoords)
+{
+#ifdef HAS_NORMAL_MAP
+    return normalize(texture(normalMap, texCoords).xyz * 2.0f - 1.0f);
+#else
+    return normalize(normal);
+#endif
+}
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec2 texCoords)
+{
+
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+
+    // specular shading
+    vec3 hVec = normalize(viewDir +  lightDir);
+    float spec = pow(max(dot(normal, hVec), 0.0), shininess);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // combine results
+
+#ifdef HAS_DIFFUSE_MAP
+    vec3 albedo = vec3(texture(diffuseMap, texCoords));
+#else
+    vec3 albedo = diffuseColor;
+#endif
+#ifdef HAS_SPECULAR_MAP
+    vec3 specularStrength = texture(specularMap, texCoords).xxx;
+#else
+    vec3 specularStrength = specularColor;
+#endif
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularStrength;
+
+    if (diff != 0.0) {
+        specular = vec3(0.0);
+    }
+
+    if (diff != 0.0f) {
+        ambient *= attenuation;
+        diffuse *= attenuation;
+        specular *= attenuation;
+    };
+    return (ambient + diffuse + specular);
+}
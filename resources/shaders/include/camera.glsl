@@ -0,0 +1,9 @@
+// camera matrices shared by every shader, streamed once per frame
+// (FrameCamera in main.cpp, same order)
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    // unjittered matrices of this and the previous frame, used for the velocity buffer
+    mat4 currViewProjection;
+    mat4 prevViewProjection;
+};
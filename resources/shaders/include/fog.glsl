@@ -0,0 +1,21 @@
+// Depth fog blending towards grey. fogNear sets how close to the camera it
+// starts to thicken.
+
+uniform float fogNear;
+
+float fogFar = 10.0f;
+
+float linearizeDepth(float depth) {
+    return (2.0 * fogNear * fogFar) / (fogFar + fogNear - (depth * 2.0 - 1.0) * (fogFar - fogNear));
+}
+
+float logisticDepth(float depth, float steepness, float offset) {
+
+    float zVal = linearizeDepth(depth);
+    return (1 / (1 + exp(-steepness * (zVal - offset))));
+}
+
+vec4 applyFog(vec4 color) {
+    float depth = logisticDepth(gl_FragCoord.z, 0.5, 5.0);
+    return color * (1.0 - depth) + vec4(depth * vec3(0.5, 0.5, 0.5), 1.0f);
+}
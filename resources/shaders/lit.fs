@@ -0,0 +1,33 @@
+#version 330 core
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity;
+
+// Opaque surfaces lit by one point light. Compiled per permutation, see
+// rg::ShaderFeature: the HAS_*_MAP bits follow the maps of the material and
+// FOG switches the fog on.
+
+in vec2 TexCoords;
+in vec3 Normal;
+in vec3 FragPos;
+in vec4 CurrClipPos;
+in vec4 PrevClipPos;
+
+#include "include/blinn_phong.glsl"
+#ifdef FOG
+#include "include/fog.glsl"
+#endif
+
+uniform vec3 viewPosition;
+
+void main()
+{
+    vec3 normal = surfaceNormal(Normal, TexCoords);
+    vec3 viewDir = normalize(viewPosition - FragPos);
+    vec3 result = CalcPointLight(pointLight, normal, FragPos, viewDir, TexCoords);
+    FragColor = vec4(result, 1.0);
+#ifdef FOG
+    FragColor = applyFog(FragColor);
+#endif
+    // screen-space motion since the previous frame, in texture coordinates
+    Velocity = (CurrClipPos.xy / CurrClipPos.w - PrevClipPos.xy / PrevClipPos.w) * 0.5;
+}
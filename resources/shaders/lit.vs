@@ -6,10 +6,15 @@ layout (location = 2) in vec2 aTexCoords;
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
+out vec4 CurrClipPos;
+out vec4 PrevClipPos;
+
+#include "include/camera.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// previous frame model matrix, used for the velocity buffer
+uniform mat4 prevModel;
 
 void main()
 {
@@ -17,4 +22,6 @@ void main()
     Normal = aNormal;
     TexCoords = aTexCoords;    
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+    CurrClipPos = currViewProjection * vec4(FragPos, 1.0);
+    PrevClipPos = prevViewProjection * prevModel * vec4(aPos, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+layout (location = 0) out vec4 FragColor;
+// alpha 0 so blending leaves the velocity of the opaque surface unchanged
+layout (location = 1) out vec4 Velocity;
+
+// written by the windows pass, see WeightedBlendedOIT.h
+uniform sampler2D accumulationTexture;
+uniform sampler2D weightTexture;
+
+void main()
+{
+    // the targets match the scene viewport texel for texel
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec4 accumulation = texelFetch(accumulationTexture, texel, 0);
+    float revealage = accumulation.a;
+    // nothing transparent covers this pixel
+    if (revealage >= 1.0)
+        discard;
+    float weight = texelFetch(weightTexture, texel, 0).r;
+    vec3 average = accumulation.rgb / max(weight, 1e-5);
+    // blended with SRC_ALPHA, ONE_MINUS_SRC_ALPHA over the opaque scene
+    FragColor = vec4(average, 1.0 - revealage);
+    Velocity = vec4(0.0);
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+layout (location = 0) out vec4 FragColor;
+// alpha 0 so blending leaves the velocity of the scene unchanged
+layout (location = 1) out vec4 Velocity;
+
+// result of the jump flooding passes
+uniform sampler2D seedTexture;
+uniform vec3 color;
+uniform float width;
+
+void main()
+{
+    vec2 seed = texelFetch(seedTexture, ivec2(gl_FragCoord.xy), 0).xy;
+    if (seed.x < 0.0)
+        discard;
+    // 0 inside the selection, which stays as it is
+    float distance = length(seed - gl_FragCoord.xy);
+    float coverage = clamp(width + 0.5 - distance, 0.0, 1.0);
+    if (distance < 0.5 || coverage <= 0.0)
+        discard;
+    FragColor = vec4(color, coverage);
+    Velocity = vec4(0.0);
+}
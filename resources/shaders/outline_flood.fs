@@ -0,0 +1,33 @@
+#version 330 core
+
+layout (location = 0) out vec2 Seed;
+
+// nearest seed found so far per pixel, negative where there is none
+uniform sampler2D seedTexture;
+uniform int stepSize;
+
+// one jump flooding pass: keep the nearest of the seeds stepSize pixels away
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 size = textureSize(seedTexture, 0);
+    vec2 nearest = vec2(-1.0);
+    float nearestDistance = 1e20;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 neighbour = texel + ivec2(x, y) * stepSize;
+            if (any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, size)))
+                continue;
+            vec2 seed = texelFetch(seedTexture, neighbour, 0).xy;
+            if (seed.x < 0.0)
+                continue;
+            vec2 offset = seed - gl_FragCoord.xy;
+            float distance = dot(offset, offset);
+            if (distance < nearestDistance) {
+                nearestDistance = distance;
+                nearest = seed;
+            }
+        }
+    }
+    Seed = nearest;
+}
@@ -0,0 +1,9 @@
+#version 330 core
+
+layout (location = 0) out vec2 Seed;
+
+// only runs for selected pixels, the stencil test does the masking
+void main()
+{
+    Seed = gl_FragCoord.xy;
+}
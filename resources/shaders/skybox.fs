@@ -1,12 +1,16 @@
 
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity;
 
 in vec3 texCoords;
+in vec4 CurrClipPos;
+in vec4 PrevClipPos;
 
 uniform samplerCube skybox;
 
 void main()
 {    
     FragColor = texture(skybox, texCoords);
+    Velocity = (CurrClipPos.xy / CurrClipPos.w - PrevClipPos.xy / PrevClipPos.w) * 0.5;
 }
\ No newline at end of file
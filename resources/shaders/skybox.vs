@@ -2,13 +2,21 @@
 layout (location = 0) in vec3 aPos;
 
 out vec3 texCoords;
+out vec4 CurrClipPos;
+out vec4 PrevClipPos;
 
 uniform mat4 projection;
 uniform mat4 view;
 
+// unjittered rotation-only matrices of this and the previous frame
+uniform mat4 currViewProjection;
+uniform mat4 prevViewProjection;
+
 void main()
 {
     vec4 pos = projection * view * vec4(aPos, 1.0f);
     gl_Position = vec4(pos.x, pos.y, pos.w, pos.w);
     texCoords = vec3(aPos.x, aPos.y, -aPos.z);
+    CurrClipPos = currViewProjection * vec4(aPos, 1.0f);
+    PrevClipPos = prevViewProjection * vec4(aPos, 1.0f);
 }    
\ No newline at end of file
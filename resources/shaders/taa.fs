@@ -0,0 +1,77 @@
+#version 330 core
+
+out vec4 FragColor;
+in vec2 texCoords;
+
+// jittered scene colour and velocity, rendered into a sub-rectangle of their textures
+uniform sampler2D currentTexture;
+uniform sampler2D velocityTexture;
+// resolved output of the previous frame at native resolution
+uniform sampler2D historyTexture;
+
+uniform vec2 currentUvScale;
+uniform bool historyValid;
+uniform float feedback;
+
+// Tonemapped weighting keeps bright HDR samples from dominating the blend.
+vec3 tonemap(vec3 c) {
+    return c / (1.0f + max(c.r, max(c.g, c.b)));
+}
+
+vec3 untonemap(vec3 c) {
+    return c / max(1.0f - max(c.r, max(c.g, c.b)), 1e-4f);
+}
+
+vec3 rgbToYCoCg(vec3 c) {
+    return vec3(0.25f * c.r + 0.5f * c.g + 0.25f * c.b,
+                0.5f * c.r - 0.5f * c.b,
+                -0.25f * c.r + 0.5f * c.g - 0.25f * c.b);
+}
+
+vec3 yCoCgToRgb(vec3 c) {
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+void main()
+{
+    vec2 currentUv = texCoords * currentUvScale;
+    vec2 currentTexel = 1.0f / vec2(textureSize(currentTexture, 0));
+    vec2 uvMax = currentUvScale - 0.5f * currentTexel;
+
+    // 3x3 neighbourhood of the current frame; its colour box bounds the history
+    vec3 current = vec3(0.0f);
+    vec3 boxMin = vec3(1e9f);
+    vec3 boxMax = vec3(-1e9f);
+    vec2 velocity = vec2(0.0f);
+    float longestVelocity = -1.0f;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            vec2 uv = clamp(currentUv + vec2(x, y) * currentTexel, 0.5f * currentTexel, uvMax);
+            vec3 c = rgbToYCoCg(tonemap(texture(currentTexture, uv).rgb));
+            boxMin = min(boxMin, c);
+            boxMax = max(boxMax, c);
+            if (x == 0 && y == 0)
+                current = c;
+            // dilate motion so edges of moving objects reproject with the object
+            vec2 v = texture(velocityTexture, uv).xy;
+            float len = dot(v, v);
+            if (len > longestVelocity) {
+                longestVelocity = len;
+                velocity = v;
+            }
+        }
+    }
+
+    vec2 historyUv = texCoords - velocity;
+    bool offscreen = any(lessThan(historyUv, vec2(0.0f))) || any(greaterThan(historyUv, vec2(1.0f)));
+    if (!historyValid || offscreen) {
+        FragColor = vec4(untonemap(yCoCgToRgb(current)), 1.0f);
+        return;
+    }
+
+    vec3 history = rgbToYCoCg(tonemap(texture(historyTexture, historyUv).rgb));
+    history = clamp(history, boxMin, boxMax);
+
+    vec3 resolved = mix(current, history, feedback);
+    FragColor = vec4(untonemap(yCoCgToRgb(resolved)), 1.0f);
+}
@@ -1,15 +1,21 @@
 #version 330 core
 
-out vec4 FragColor;
+// weighted blended OIT, see WeightedBlendedOIT.h for the target layout
+layout (location = 0) out vec4 Accumulation;
+layout (location = 1) out vec4 Weight;
 in vec2 TexCoords;
 
 uniform sampler2D diffuse0;
 
 void main()
 {
+	vec4 color = texture(diffuse0, TexCoords);
 	// discards all fragments with alpha less than 0.1
-	if (texture(diffuse0, TexCoords).a < 0.1)
+	if (color.a < 0.1)
 		discard;
-	// outputs final color
-	FragColor = texture(diffuse0, TexCoords) * vec4(1.0, 1.0, 1.0, 0.5);
-}
\ No newline at end of file
+	color.a *= 0.5;
+	// nearer and more opaque surfaces dominate the average (McGuire and Bavoil, eq. 7)
+	float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+	Accumulation = vec4(color.rgb * color.a * weight, color.a);
+	Weight = vec4(color.a * weight);
+}
@@ -7,9 +7,9 @@ out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
+#include "include/camera.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
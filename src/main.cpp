@@ -6,6 +6,29 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/model.h>
 #include <learnopengl/shader.h>
+#include <rg/Benchmark.h>
+#include <rg/CommandList.h>
+#include <rg/CookedAssets.h>
+#include <rg/DrawStats.h>
+#include <rg/FrameQueue.h>
+#include <rg/DynamicResolution.h>
+#include <rg/FrameRingBuffer.h>
+#include <rg/GLDebug.h>
+#include <rg/GLState.h>
+#include <rg/InputRecorder.h>
+#include <rg/JobSystem.h>
+#include <rg/Material.h>
+#include <rg/MemoryTracker.h>
+#include <rg/Pak.h>
+#include <rg/Regression.h>
+#include <rg/Profiler.h>
+#include <rg/RenderTarget.h>
+#include <rg/SelectionOutline.h>
+#include <rg/ShaderCache.h>
+#include <rg/ShaderReloader.h>
+#include <rg/TemporalAA.h>
+#include <rg/TextureStreamer.h>
+#include <rg/WeightedBlendedOIT.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,7 +37,14 @@
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
@@ -31,6 +61,10 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action,
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
 
+// current framebuffer size, kept up to date by framebuffer_size_callback
+int windowWidth = SCR_WIDTH;
+int windowHeight = SCR_HEIGHT;
+
 // camera
 
 float lastX = SCR_WIDTH / 2.0f;
@@ -40,6 +74,9 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// --record / --replay of the window input
+rg::InputRecorder inputRecorder;
+
 struct PointLight {
   glm::vec3 position;
   glm::vec3 ambient;
@@ -51,14 +88,29 @@ struct PointLight {
   float quadratic;
 };
 
+// Edge anti-aliasing applied on top of (or instead of) TAA
+enum AntiAliasing { AA_NONE, AA_FXAA, AA_MSAA_4X, AA_COUNT };
+const char *antiAliasingNames[AA_COUNT] = {"None", "FXAA", "MSAA 4x"};
+
 struct ProgramState {
   glm::vec3 clearColor = glm::vec3(0.2);
   bool ImGuiEnabled = false;
   Camera camera;
   bool CameraMouseMovementUpdateEnabled = true;
+  bool ProfilerWindowVisible = false;
+  bool MemoryWindowVisible = false;
   glm::vec3 backpackPosition = glm::vec3(0.0f);
   float backpackScale = 1.0f;
   PointLight pointLight;
+  // settings only, the render thread owns the live controller and TAA targets
+  rg::DynamicResolution dynamicResolution;
+  rg::TemporalAA temporalAA;
+  int antiAliasing = AA_FXAA;
+  // what the mip levels of streamed textures may take on the GPU
+  int textureBudgetMB = 256;
+  // frames of a trace capture requested from the UI, passed on with the next
+  // frame
+  int captureFrames = 0;
   ProgramState() : camera(glm::vec3(0.0f, 0.0f, 3.0f)) {}
 
   void SaveToFile(std::string filename);
@@ -91,7 +143,250 @@ void ProgramState::LoadFromFile(std::string filename) {
 
 ProgramState *programState;
 
-void DrawImGui(ProgramState *programState);
+// ImGui reuses its draw lists on the next NewFrame(), so the frame handed to
+// the render thread carries a copy of them.
+struct UiDrawData {
+  ImDrawData drawData;
+  std::vector<ImDrawList *> lists;
+
+  ~UiDrawData() { clear(); }
+
+  // main thread only, ImGui's allocator is not thread safe
+  void capture(const ImDrawData *source) {
+    clear();
+    drawData = *source;
+    for (int i = 0; i < source->CmdListsCount; i++)
+      lists.push_back(source->CmdLists[i]->CloneOutput());
+    drawData.CmdLists = lists.data();
+  }
+
+  void clear() {
+    for (ImDrawList *list : lists)
+      IM_DELETE(list);
+    lists.clear();
+    drawData.Clear();
+  }
+};
+
+// What the render thread reports back after every frame. The UI runs on the
+// main thread and reads this instead of the profiler and the controllers.
+struct RenderStats {
+  struct Pass {
+    const char *name;
+    int depth;
+    rg::ProfileStats stats;
+  };
+
+  float renderScale = 1.0f;
+  float dynamicResolutionGpuMs = 0.0f;
+  // smoothed GPU cost of each anti-aliasing mode, filled in while it is active
+  float aaFrameMs[AA_COUNT] = {};
+  float aaStageMs[AA_COUNT] = {};
+  float cpuFrameMs = 0.0f;
+  float gpuFrameMs = 0.0f;
+  float cpuHistory[rg::Profiler::kHistory] = {};
+  float gpuHistory[rg::Profiler::kHistory] = {};
+  int historyOffset = 0;
+  bool capturing = false;
+  std::vector<Pass> passes;
+  rg::GLStateStats glState;
+  rg::TextureStreamingStats textureStreaming;
+};
+
+std::mutex renderStatsMutex;
+RenderStats renderStats;
+
+// Everything the object transforms depend on. The previous frame's copy lets the
+// velocity pass reconstruct where each object was one frame ago.
+struct SceneParams {
+  glm::vec3 origin = glm::vec3(0.0f);
+  float scale = 1.0f;
+  float time = 0.0f;
+};
+
+// Camera matrices shared by all scene passes. projection carries the TAA
+// jitter, the view-projection pair used for the velocity buffer does not.
+// Uploaded as is into the std140 Camera uniform block of the scene shaders.
+struct FrameCamera {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 viewProjection;
+  glm::mat4 prevViewProjection;
+};
+
+// Everything the render thread needs to draw one frame, produced by the main
+// thread from its input and ProgramState. The render thread reads nothing else
+// that the main thread writes.
+struct FrameSnapshot {
+  int frameIndex = 0;
+  float time = 0.0f;
+  int width = SCR_WIDTH;
+  int height = SCR_HEIGHT;
+  glm::vec3 clearColor;
+  glm::mat4 view;
+  glm::vec3 viewPosition;
+  float zoom = 45.0f;
+  SceneParams scene;
+  PointLight pointLight;
+  bool dynamicResolution = false;
+  float gpuBudgetMs = 16.6f;
+  float minRenderScale = 0.5f;
+  bool temporalAA = false;
+  float taaFeedback = 0.9f;
+  int antiAliasing = AA_NONE;
+  size_t textureBudget = 256u << 20;
+  bool detailedProfiling = false;
+  int captureFrames = 0;
+  // empty while ImGui is hidden
+  UiDrawData ui;
+};
+
+// A scene pass that records into its own command list on a job system worker.
+// The lists are replayed on the render thread in pass order. Transparent
+// passes are replayed into the OIT targets and composited afterwards.
+struct ScenePass {
+  const char *name;
+  const char *jobName;
+  std::function<void(rg::CommandList &, const FrameSnapshot &)> record;
+  bool transparent = false;
+  rg::CommandList commands{};
+};
+
+glm::mat4 cobraTransform(const SceneParams &scene) {
+  glm::mat4 transform = glm::mat4(1.0f);
+  // translate it down so it's at the center of the scene
+  transform = glm::translate(transform, scene.origin);
+  // it's a bit too big for our scene, so scale it down
+  return glm::scale(transform, glm::vec3(scene.scale));
+}
+
+glm::mat4 buildingTransform(const SceneParams &scene, glm::vec3 offset) {
+  glm::mat4 transform = glm::mat4(1.0f);
+  transform = glm::translate(transform, scene.origin + offset);
+  return glm::scale(transform, glm::vec3(scene.scale));
+}
+
+glm::mat4 roadTransform(const SceneParams &scene, glm::vec3 offset) {
+  glm::mat4 transform = glm::mat4(1.0f);
+  transform = glm::translate(transform, scene.origin + offset);
+  return glm::scale(transform, glm::vec3(scene.scale * 5.0));
+}
+
+// window panes rotate around the y axis over time
+glm::mat4 windowTransform(const SceneParams &scene, int i) {
+  glm::mat4 transform = glm::mat4(1.0f);
+  transform =
+      glm::translate(transform, scene.origin + glm::vec3(0.0, 3.0, i * 4));
+  transform = glm::scale(transform, glm::vec3(scene.scale * 5.0));
+  return glm::rotate(transform, glm::radians(cos(scene.time) * 180),
+                     glm::vec3(0, 1, 0));
+}
+
+// uniform buffer binding point of the Camera block
+const unsigned int kCameraBlockBinding = 0;
+
+void bindCameraBlock(Shader &shader) {
+  unsigned int index = glGetUniformBlockIndex(shader.ID, "Camera");
+  if (index != GL_INVALID_INDEX)
+    glUniformBlockBinding(shader.ID, index, kCameraBlockBinding);
+}
+
+// points the material block and samplers of shader at the slots
+// rg::Material binds them to
+void bindMaterialSlots(Shader &shader) {
+  unsigned int index = glGetUniformBlockIndex(shader.ID, "MaterialParams");
+  if (index != GL_INVALID_INDEX)
+    glUniformBlockBinding(shader.ID, index, rg::Material::kBlockBinding);
+  shader.use();
+  shader.setInt("diffuseMap", rg::Material::kDiffuseUnit);
+  shader.setInt("specularMap", rg::Material::kSpecularUnit);
+  shader.setInt("normalMap", rg::Material::kNormalUnit);
+}
+
+void setModel(rg::CommandList &list, const glm::mat4 &model,
+              const glm::mat4 &prevModel) {
+  list.setMat4("model", model);
+  list.setMat4("prevModel", prevModel);
+}
+
+// Selected objects write kSelectionStencil where they are visible and
+// everything else clears it; the selection outline is drawn around that mask.
+const GLint kSelectionStencil = 1;
+
+void setSelected(rg::CommandList &list, bool selected) {
+  list.stencilFunc(GL_ALWAYS, selected ? kSelectionStencil : 0, 0xFF);
+}
+
+// the lit.vs / lit.fs permutations by feature key
+using LitPrograms = std::map<unsigned int, rg::ProgramInfo>;
+
+// features every lit permutation has on top of the maps of the mesh
+const unsigned int kLitFeatures = rg::FOG;
+
+// model matrix of one instance in this and the previous frame
+struct Instance {
+  glm::mat4 model;
+  glm::mat4 prevModel;
+};
+
+void setPointLight(rg::CommandList &list, const PointLight &light) {
+  list.setVec3("pointLight.position", light.position);
+  list.setVec3("pointLight.ambient", light.ambient);
+  list.setVec3("pointLight.diffuse", light.diffuse);
+  list.setVec3("pointLight.specular", light.specular);
+  list.setFloat("pointLight.constant", light.constant);
+  list.setFloat("pointLight.linear", light.linear);
+  list.setFloat("pointLight.quadratic", light.quadratic);
+}
+
+// Tells the texture streamer how large the maps of material appear on mesh
+// drawn with model this frame.
+void requestMips(const rg::Material &material, const Mesh &mesh,
+                 const glm::mat4 &model) {
+  rg::TextureStreamer &streamer = rg::textureStreamer();
+  float scale = std::max({glm::length(glm::vec3(model[0])),
+                          glm::length(glm::vec3(model[1])),
+                          glm::length(glm::vec3(model[2]))});
+  glm::vec3 center = glm::vec3(model * glm::vec4(mesh.boundsCenter, 1.0f));
+  float uvPerPixel = streamer.uvPerPixel(center, mesh.boundsRadius * scale,
+                                         mesh.uvDensity / scale);
+  const rg::MaterialDesc &desc = material.desc();
+  for (GLuint map : {desc.DiffuseMap, desc.SpecularMap, desc.NormalMap})
+    streamer.use(map, uvPerPixel);
+}
+
+// Records the instances of model lit by light. Meshes come grouped by
+// material and sorted by the maps those have; the program and the per-pass
+// uniforms change only between permutations and the material only between
+// groups, so meshes without a normal map do not pay for sampling one.
+void recordLit(rg::CommandList &list, const LitPrograms &programs,
+               const Model &model, const std::vector<Instance> &instances,
+               const PointLight &light, const glm::vec3 &viewPosition,
+               float fogNear = 0.01f) {
+  unsigned int current = ~0u;
+  for (const Model::MeshGroup &group : model.MeshGroups()) {
+    unsigned int features = group.material->features();
+    if (features != current) {
+      current = features;
+      list.use(programs.at(kLitFeatures | features));
+      setPointLight(list, light);
+      list.setVec3("viewPosition", viewPosition);
+      list.setFloat("fogNear", fogNear);
+    }
+    group.material->record(list);
+    for (const Instance &instance : instances) {
+      setModel(list, instance.model, instance.prevModel);
+      for (const Mesh *mesh : group.meshes) {
+        requestMips(*group.material, *mesh, instance.model);
+        mesh->RecordDraw(list);
+      }
+    }
+  }
+}
+
+void DrawImGui(ProgramState *programState, const RenderStats &stats);
+
+void DrawMemoryWindow(bool *open);
 
 float rectangleVertices[] = {
     // Coords    // texCoords
@@ -108,7 +403,82 @@ unsigned int skyboxIndices[] = {1, 2, 6, 6, 5, 1, 0, 4, 7, 7, 3, 0,
                                 4, 5, 6, 6, 7, 4, 0, 3, 2, 2, 1, 0,
                                 0, 1, 5, 5, 4, 0, 3, 7, 6, 6, 2, 3};
 
-auto main() -> int {
+auto main(int argc, char **argv) -> int {
+  // command line
+  // --trace <frames>: write the first frames frames to trace.json
+  // --benchmark <config.json>: render a scripted flythrough in a hidden window
+  //                            and write frame time statistics, see Benchmark.h
+  // --record <file>: log the input and frame timing of this session
+  // --replay <file>: rerun a recorded session with its exact time steps
+  // --workers <n>: size of the job system's worker pool, by default all
+  //     hardware threads but two
+  // --texture-budget <MiB>: GPU memory the streamed texture mips may take
+  // --memory-report <file>: write what the GPU and CPU resources hold after
+  //     the last frame as JSON, see MemoryTracker.h
+  // --gl-debug [--gl-debug-sync]: report driver errors and warnings through
+  //     KHR_debug (always on in RG_GL_DEBUG builds), optionally synchronously
+  // --gl-state-validate: check the GL state shadow against glGet* whenever it
+  //     drops a state change, and report where it drifted
+  // --regression <config.json> [--update-golden] [--update-baseline]:
+  //     render canonical poses in a hidden window and check them against
+  //     golden images and frame cost budgets, see Regression.h
+  int traceFrames = 0;
+  std::string recordPath, replayPath;
+  bool benchmarking = false;
+  rg::Benchmark benchmark;
+  bool regressionTesting = false;
+  rg::RegressionSuite regression;
+  std::string regressionPath;
+#ifdef RG_GL_DEBUG
+  bool glDebugOutput = true;
+#else
+  bool glDebugOutput = false;
+#endif
+  rg::GLDebugOptions glDebugOptions;
+  bool validateGLState = false;
+  int jobWorkers = -1;
+  int textureBudgetMB = 0;
+  std::string memoryReportPath;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      traceFrames = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc) {
+      if (!benchmark.load(argv[++i]))
+        return -1;
+      benchmarking = true;
+    } else if (std::strcmp(argv[i], "--regression") == 0 && i + 1 < argc) {
+      regressionPath = argv[++i];
+      regressionTesting = true;
+    } else if (std::strcmp(argv[i], "--update-golden") == 0) {
+      regression.UpdateGolden = true;
+    } else if (std::strcmp(argv[i], "--update-baseline") == 0) {
+      regression.UpdateBaseline = true;
+    } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      jobWorkers = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+      textureBudgetMB = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--memory-report") == 0 && i + 1 < argc) {
+      memoryReportPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--gl-debug") == 0) {
+      glDebugOutput = true;
+    } else if (std::strcmp(argv[i], "--gl-debug-sync") == 0) {
+      glDebugOutput = true;
+      glDebugOptions.Synchronous = true;
+    } else if (std::strcmp(argv[i], "--gl-state-validate") == 0) {
+      validateGLState = true;
+    } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    }
+  }
+  if (regressionTesting && !regression.load(regressionPath))
+    return -1;
+  // headless modes run in a hidden window with their own settings
+  bool headless = benchmarking || regressionTesting;
+  const rg::JsonValue &headlessSettings =
+      benchmarking ? benchmark.settings() : regression.settings();
+
   // glfw: initialize and configure
   // ------------------------------
   glfwInit();
@@ -119,17 +489,33 @@ auto main() -> int {
 #ifdef __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+  if (glDebugOutput)
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+  // headless runs render offscreen, which also works under xvfb-run on CI
+  if (headless)
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
   // glfw window creation
   // --------------------
-  GLFWwindow *window =
-      glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", nullptr, nullptr);
+  int initialWidth = SCR_WIDTH, initialHeight = SCR_HEIGHT;
+  if (benchmarking) {
+    initialWidth = benchmark.Width;
+    initialHeight = benchmark.Height;
+  } else if (regressionTesting) {
+    initialWidth = regression.Width;
+    initialHeight = regression.Height;
+  }
+  GLFWwindow *window = glfwCreateWindow(initialWidth, initialHeight,
+                                        "LearnOpenGL", nullptr, nullptr);
   if (window == nullptr) {
     std::cout << "Failed to create GLFW window" << std::endl;
     glfwTerminate();
     return -1;
   }
   glfwMakeContextCurrent(window);
+  // measure how fast frames can be rendered, not the refresh rate
+  if (headless)
+    glfwSwapInterval(0);
   glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
   glfwSetCursorPosCallback(window, mouse_callback);
   glfwSetScrollCallback(window, scroll_callback);
@@ -143,13 +529,68 @@ auto main() -> int {
     std::cout << "Failed to initialize GLAD" << std::endl;
     return -1;
   }
+  if (glDebugOutput &&
+      !rg::glDebug().install((GLADloadproc)glfwGetProcAddress, glDebugOptions))
+    std::cout << "KHR_debug output is not available on this context"
+              << std::endl;
+  // state changes go through the shadow in GLState, which drops redundant ones
+  rg::GLState &glState = rg::glState();
+  glState.Validate = validateGLState;
 
   // tell stb_image.h to flip loaded texture's on the y-axis (before loading
   // model).
   stbi_set_flip_vertically_on_load(true);
 
   programState = new ProgramState;
-  programState->LoadFromFile("resources/program_state.txt");
+
+  // The profiler keeps everything timed before the first frame, so asset loading
+  // shows up at the start of every trace capture.
+  rg::Profiler &profiler = rg::profiler();
+  profiler.init();
+  if (traceFrames > 0)
+    profiler.requestCapture(traceFrames, "trace.json");
+  // worker pool for CPU work such as mesh processing and texture decoding
+  rg::jobs().init(jobWorkers);
+
+  if (headless) {
+    // Start from defaults rather than the saved state so runs are comparable;
+    // dynamic resolution would change the workload between runs, so it is off
+    // unless the config asks for it.
+    const rg::JsonValue &settings = headlessSettings;
+    programState->dynamicResolution.Enabled =
+        settings["dynamicResolution"].asBool(false);
+    programState->temporalAA.Enabled = settings["temporalAA"].asBool(true);
+    std::string antiAliasing =
+        settings["antiAliasing"].asString(antiAliasingNames[AA_FXAA]);
+    for (int i = 0; i < AA_COUNT; i++) {
+      if (antiAliasing == antiAliasingNames[i])
+        programState->antiAliasing = i;
+    }
+    programState->CameraMouseMovementUpdateEnabled = false;
+    // streamed mips arrive a few frames late and not at the same frame every
+    // run, so textures load whole unless the config asks for streaming
+    rg::textureStreamer().Enabled = settings["textureStreaming"].asBool(false);
+    // every pass of every frame ends up in the results
+    profiler.Detailed = true;
+    profiler.WaitForResults = true;
+  } else {
+    programState->LoadFromFile("resources/program_state.txt");
+    Camera &camera = programState->camera;
+    rg::InputStartState start;
+    if (!replayPath.empty()) {
+      if (!inputRecorder.startReplay(replayPath, start))
+        return -1;
+      camera = Camera(start.position, glm::vec3(0.0f, 1.0f, 0.0f), start.yaw,
+                      start.pitch);
+      camera.Zoom = start.zoom;
+    } else if (!recordPath.empty()) {
+      start = {camera.Position, camera.Yaw, camera.Pitch, camera.Zoom};
+      if (!inputRecorder.startRecording(recordPath, start))
+        return -1;
+    }
+  }
+  if (textureBudgetMB > 0)
+    programState->textureBudgetMB = textureBudgetMB;
   if (programState->ImGuiEnabled) {
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
   }
@@ -161,45 +602,70 @@ auto main() -> int {
 
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init("#version 330 core");
+  // creates the font texture now, while this thread owns the GL context
+  ImGui_ImplOpenGL3_NewFrame();
 
   // configure global opengl state
   // -----------------------------
   // Testiranje dubine
-  glEnable(GL_DEPTH_TEST);
+  glState.enable(GL_DEPTH_TEST);
   // Stencil test
-  glEnable(GL_STENCIL_TEST);
-  glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+  glState.enable(GL_STENCIL_TEST);
+  glState.stencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
   // Face-culling
-  glEnable(GL_CULL_FACE);
-  glCullFace(GL_BACK);
-  glFrontFace(GL_CW);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glState.enable(GL_CULL_FACE);
+  glState.cullFace(GL_BACK);
+  glState.frontFace(GL_CW);
+  glState.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   // GAMMA KOREKCIJA
   double gamma = 0.4;
-  glEnable(GL_FRAMEBUFFER_SRGB);
+  glState.enable(GL_FRAMEBUFFER_SRGB);
   // build and compile shaders
   // -------------------------
   Shader framebufferShader("resources/shaders/framebuffer.vs",
                            "resources/shaders/framebuffer.fs");
+  Shader taaShader("resources/shaders/framebuffer.vs",
+                   "resources/shaders/taa.fs");
+  Shader fxaaShader("resources/shaders/framebuffer.vs",
+                    "resources/shaders/fxaa.fs");
+  Shader oitCompositeShader("resources/shaders/framebuffer.vs",
+                            "resources/shaders/oit_composite.fs");
+  Shader outlineSeedShader("resources/shaders/framebuffer.vs",
+                           "resources/shaders/outline_seed.fs");
+  Shader outlineFloodShader("resources/shaders/framebuffer.vs",
+                            "resources/shaders/outline_flood.fs");
+  Shader outlineCompositeShader("resources/shaders/framebuffer.vs",
+                                "resources/shaders/outline_composite.fs");
   Shader skyboxShader("resources/shaders/skybox.vs",
                       "resources/shaders/skybox.fs");
   Shader windowsShader("resources/shaders/windows.vs",
                        "resources/shaders/windows.fs");
-  Shader cobraShader("resources/shaders/cobra.vs",
-                     "resources/shaders/cobra.fs");
-  Shader cobraOutlineShader("resources/shaders/cobra_outline.vs",
-                            "resources/shaders/cobra_outline.fs");
-  Shader rb1Shader("resources/shaders/building.vs",
-                   "resources/shaders/building.fs");
-  Shader rb2Shader("resources/shaders/building.vs",
-                   "resources/shaders/building.fs");
-  Shader rb3Shader("resources/shaders/building.vs",
-                   "resources/shaders/building.fs");
-  Shader rb4Shader("resources/shaders/building.vs",
-                   "resources/shaders/building.fs");
-  Shader roadShader("resources/shaders/road.vs", "resources/shaders/road.fs");
+  // Shaders are rebuilt when their sources change. The setup functions
+  // restore what a new program does not get every frame.
+  rg::ShaderReloader shaderReloader;
+  // uniform locations for recording command lists off the GL thread
+  rg::ProgramInfo windowsProgram;
+  LitPrograms litPrograms;
+  auto addSceneShader = [&](Shader &shader, rg::ProgramInfo &program) {
+    shaderReloader.add(shader, [&shader, &program] {
+      bindCameraBlock(shader);
+      bindMaterialSlots(shader);
+      program = rg::ProgramInfo(shader.ID);
+    });
+  };
+  addSceneShader(windowsShader, windowsProgram);
+  shaderReloader.add(skyboxShader);
+  shaderReloader.add(outlineSeedShader);
+  // everything uploaded once per frame streams through this buffer
+  rg::FrameRingBuffer frameData;
+  if (!frameData.init(64 * 1024, (GLADloadproc)glfwGetProcAddress))
+    std::cout << "Failed to create the per-frame data buffer" << std::endl;
   // load models
   // -----------
+  // Cooked assets come from one mapped package when it exists; whatever it
+  // does not have is loaded from the loose files.
+  if (rg::pak().open("resources/assets.pak"))
+    std::cout << "Loading assets from " << rg::pak().path() << std::endl;
   Model windowsModel("resources/objects/windows/scene.gltf");
   Model cobraModel("resources/objects/cobra/Shelby.obj");
   Model rb1Model("resources/objects/buildings/rb1.obj");
@@ -207,13 +673,23 @@ auto main() -> int {
   Model rb3Model("resources/objects/buildings/rb3.obj");
   Model rb4Model("resources/objects/buildings/rb4.obj");
   Model roadModel("resources/objects/road/road.obj");
-
-  cobraModel.SetShaderTextureNamePrefix("material.");
-  rb1Model.SetShaderTextureNamePrefix("material.");
-  rb2Model.SetShaderTextureNamePrefix("material.");
-  rb3Model.SetShaderTextureNamePrefix("material.");
-  rb4Model.SetShaderTextureNamePrefix("material.");
-  roadModel.SetShaderTextureNamePrefix("material.");
+  // One lit permutation per combination of maps the meshes have, compiled
+  // once however many models need it.
+  rg::ShaderCache shaderCache;
+  for (const Model *model : {&cobraModel, &rb1Model, &rb2Model, &rb3Model,
+                             &rb4Model, &roadModel}) {
+    for (unsigned int features : model->Features()) {
+      bool created = false;
+      Shader &shader = shaderCache.get("resources/shaders/lit.vs",
+                                       "resources/shaders/lit.fs",
+                                       kLitFeatures | features, &created);
+      if (created)
+        addSceneShader(shader, litPrograms[kLitFeatures | features]);
+    }
+  }
+  // the material buffer has to exist before the first command list records
+  // a bind of it
+  rg::materials().upload();
 
   // Inicijalne postavke skybox-a
   skyboxShader.use();
@@ -224,18 +700,23 @@ auto main() -> int {
   glGenVertexArrays(1, &skyboxVAO);
   glGenBuffers(1, &skyboxVBO);
   glGenBuffers(1, &skyboxEBO);
-  glBindVertexArray(skyboxVAO);
+  glState.bindVertexArray(skyboxVAO);
   glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
   glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices,
                GL_STATIC_DRAW);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, skyboxEBO);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(skyboxIndices), &skyboxIndices,
                GL_STATIC_DRAW);
+  rg::MemoryTracker &memory = rg::memoryTracker();
+  memory.bufferAllocated(skyboxVBO, sizeof(skyboxVertices), GL_STATIC_DRAW,
+                         rg::MemoryCategory::Geometry, "Skybox");
+  memory.bufferAllocated(skyboxEBO, sizeof(skyboxIndices), GL_STATIC_DRAW,
+                         rg::MemoryCategory::Geometry, "Skybox");
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float),
                         (void *)nullptr);
   glEnableVertexAttribArray(0);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  glState.bindVertexArray(0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   // All the faces of the cubemap (make sure they are in this exact order)
@@ -248,7 +729,7 @@ auto main() -> int {
   // Kreiraj cubemap teksturu
   unsigned int cubemapTexture;
   glGenTextures(1, &cubemapTexture);
-  glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+  glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -256,14 +737,28 @@ auto main() -> int {
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
   // glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
+  // Cube map faces are stored top row first, as asset_cook keeps them. The
+  // flip set for the models has to be off before the first face is read.
+  stbi_set_flip_vertically_on_load(false);
   for (unsigned int i = 0; i < 6; i++) {
+    PROFILE_CPU_SCOPE("Cubemap " + facesCubemap[i]);
+    rg::MemoryOwnerScope owner("Skybox");
+    rg::CookedTexture cooked(rg::pak().find(facesCubemap[i]));
+    if (cooked.valid()) {
+      cooked.upload(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 1, GL_SRGB);
+      cooked.track(cubemapTexture, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, 1,
+                   GL_SRGB);
+      continue;
+    }
     int width, height, nrCh;
     unsigned char *data =
         stbi_load(facesCubemap[i].c_str(), &width, &height, &nrCh, 0);
     if (data) {
-      stbi_set_flip_vertically_on_load(false);
       glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_SRGB, width,
                    height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+      memory.textureLevelAllocated(
+          cubemapTexture, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_SRGB,
+          width, height, 0, rg::MemoryCategory::Texture);
       stbi_image_free(data);
     } else {
       std::cout << "Failed to load texture: " << facesCubemap[i] << std::endl;
@@ -272,57 +767,58 @@ auto main() -> int {
   }
 
   // Inicijalne postavke svetla
-  PointLight &pointLight = programState->pointLight;
-  pointLight.position = glm::vec3(4.0f, 4.0, 0.0);
-  pointLight.ambient = glm::vec3(0.2, 0.2, 0.2);
-  pointLight.diffuse = glm::vec3(44.6, 44.6, 44.6);
-  pointLight.specular = glm::vec3(445.0, 454.0, 454.0);
+  PointLight &light = programState->pointLight;
+  light.position = glm::vec3(4.0f, 4.0, 0.0);
+  light.ambient = glm::vec3(0.2, 0.2, 0.2);
+  light.diffuse = glm::vec3(44.6, 44.6, 44.6);
+  light.specular = glm::vec3(445.0, 454.0, 454.0);
 
-  pointLight.constant = 1.0f;
-  pointLight.linear = 0.09f;
-  pointLight.quadratic = 0.032f;
+  light.constant = 1.0f;
+  light.linear = 0.09f;
+  light.quadratic = 0.032f;
 
   // draw in wireframe
   // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
   // FRAMEBUFFER
-  // Create Frame Buffer Object
-  unsigned int FBO;
-  glGenFramebuffers(1, &FBO);
-  glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-
-  // Create Framebuffer Texture
-  unsigned int framebufferTexture;
-  glGenTextures(1, &framebufferTexture);
-  glBindTexture(GL_TEXTURE_2D, framebufferTexture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, nullptr);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
-                  GL_CLAMP_TO_EDGE); // Prevents edge bleeding
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
-                  GL_CLAMP_TO_EDGE); // Prevents edge bleeding
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                         framebufferTexture, 0);
-
-  // Create Render Buffer Object
-  unsigned int RBO;
-  glGenRenderbuffers(1, &RBO);
-  glBindRenderbuffer(GL_RENDERBUFFER, RBO);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH,
-                        SCR_HEIGHT);
-  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
-                            GL_RENDERBUFFER, RBO);
+  // The scene is rendered offscreen at a fraction of the window size picked by
+  // the dynamic resolution controller and upscaled by the framebuffer pass.
+  // Linear filtering does the upscale.
+  glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+  // second attachment holds per-pixel screen-space velocity for TAA
+  rg::RenderTarget sceneTarget({{GL_RGB16F, GL_RGB, GL_FLOAT, GL_LINEAR},
+                                {GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST}});
+  sceneTarget.setName("Scene target");
+  sceneTarget.resize(windowWidth, windowHeight);
+  // Same layout with 4 samples per pixel, allocated only while MSAA is selected
+  // and resolved into sceneTarget before the post passes.
+  rg::RenderTarget msaaTarget({{GL_RGB16F, GL_RGB, GL_FLOAT, GL_NEAREST},
+                               {GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST}},
+                              true, 4);
+  msaaTarget.setName("Scene target (MSAA)");
+  // Tonemapped image at window resolution that FXAA reads from. sRGB like the
+  // back buffer: with GL_FRAMEBUFFER_SRGB on, the write encodes and sampling
+  // decodes, so the image reaches the back buffer with the same values and a
+  // single encoding on every AA path, with the precision of an sRGB target.
+  rg::RenderTarget ldrTarget(
+      {{GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR}}, false);
+  ldrTarget.setName("LDR target");
+
+  // The frame is split into consecutive Scene, AA, Post and UI spans that are
+  // always GPU timed; their sum drives the dynamic resolution controller.
+  // Individual passes are only timed while the profiler window is open or a
+  // trace is being captured.
 
   // Prepare framebuffer rectangle VBO and VAO
   unsigned int rectVAO, rectVBO;
   glGenVertexArrays(1, &rectVAO);
   glGenBuffers(1, &rectVBO);
-  glBindVertexArray(rectVAO);
+  glState.bindVertexArray(rectVAO);
   glBindBuffer(GL_ARRAY_BUFFER, rectVBO);
   glBufferData(GL_ARRAY_BUFFER, sizeof(rectangleVertices), &rectangleVertices,
                GL_STATIC_DRAW);
+  memory.bufferAllocated(rectVBO, sizeof(rectangleVertices), GL_STATIC_DRAW,
+                         rg::MemoryCategory::Geometry, "Screen quad");
   glEnableVertexAttribArray(0);
   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
                         (void *)nullptr);
@@ -330,411 +826,683 @@ auto main() -> int {
   glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
                         (void *)(2 * sizeof(float)));
 
-  // Error checking framebuffer
-  auto fboStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-  if (fboStatus != GL_FRAMEBUFFER_COMPLETE)
-    std::cout << "Framebuffer error: " << fboStatus << std::endl;
+  glState.bindVertexArray(0);
 
   // render loop
   // -----------
-  framebufferShader.use();
-  framebufferShader.setInt("screenTexture", 0);
-  framebufferShader.setFloat("gamma", gamma);
-  while (!glfwWindowShouldClose(window)) {
-    // per-frame time logic
-    // --------------------
-    float currentFrame = glfwGetTime();
-    deltaTime = currentFrame - lastFrame;
-    lastFrame = currentFrame;
-
-    // input
-    // -----
-    processInput(window);
-
-    glClearColor(pow(programState->clearColor.r, gamma),
-                 pow(programState->clearColor.g, gamma),
-                 pow(programState->clearColor.b, gamma), 1.0f);
+  shaderReloader.add(framebufferShader, [&] {
+    framebufferShader.use();
+    framebufferShader.setInt("screenTexture", 0);
+    framebufferShader.setFloat("gamma", gamma);
+  });
+  shaderReloader.add(taaShader, [&] {
+    taaShader.use();
+    taaShader.setInt("currentTexture", 0);
+    taaShader.setInt("velocityTexture", 1);
+    taaShader.setInt("historyTexture", 2);
+  });
+  shaderReloader.add(fxaaShader, [&] {
+    fxaaShader.use();
+    fxaaShader.setInt("screenTexture", 0);
+  });
+  shaderReloader.add(oitCompositeShader, [&] {
+    oitCompositeShader.use();
+    oitCompositeShader.setInt("accumulationTexture", 0);
+    oitCompositeShader.setInt("weightTexture", 1);
+  });
+  shaderReloader.add(outlineFloodShader, [&] {
+    outlineFloodShader.use();
+    outlineFloodShader.setInt("seedTexture", 0);
+  });
+  shaderReloader.add(outlineCompositeShader, [&] {
+    outlineCompositeShader.use();
+    outlineCompositeShader.setInt("seedTexture", 0);
+  });
+
+  // The main thread turns input into FrameSnapshots and the render thread,
+  // which owns the GL context from here on, draws them. The main thread may run
+  // up to two frames ahead, so input handling and UI layout of the next frame
+  // overlap GPU submission of the current one.
+  rg::FrameQueue<FrameSnapshot> frames;
+  std::atomic<bool> renderFinished(false);
+
+  // render thread state
+  // -------------------
+  // live dynamic resolution controller and TAA history; ProgramState only
+  // holds their settings
+  rg::DynamicResolution dynamicResolution;
+  rg::TemporalAA taa;
+  // accumulation targets for the transparent window panes
+  rg::WeightedBlendedOIT oit;
+  // jump flooding targets of the outline around the selected objects
+  rg::SelectionOutline selectionOutline;
+  // previous frame state for the velocity buffer
+  bool firstFrame = true;
+  SceneParams previousScene;
+  glm::mat4 previousViewProjection;
+  glm::mat4 previousSkyboxViewProjection;
+  double lastSwapTime = glfwGetTime();
+  RenderStats renderedStats;
+  // the last profiled frame the controller and the AA averages have seen
+  int lastProfiledFrame = -1;
+
+  // Scene passes after the skybox, recorded in parallel every frame and
+  // replayed in this order; they mark the selected objects in the stencil.
+  ScenePass scenePasses[] = {
+      {"Cobra", "Record Cobra",
+       [&](rg::CommandList &list, const FrameSnapshot &frame) {
+         // Namestanje svetla za shader kobre
+         PointLight pointLight = frame.pointLight;
+         pointLight.position = glm::vec3(10.0 * cos(frame.time), 10.0f,
+                                         70.0 * sin(frame.time));
+
+         // crtanje modela Shelby kobre
+         setSelected(list, true);
+         list.stencilMask(0xFF);
+         Instance cobra{cobraTransform(frame.scene),
+                        cobraTransform(previousScene)};
+         recordLit(list, litPrograms, cobraModel, {cobra}, pointLight,
+                   frame.viewPosition);
+       }},
+      {"Buildings", "Record Buildings",
+       [&](rg::CommandList &list, const FrameSnapshot &frame) {
+         const SceneParams &scene = frame.scene;
+         PointLight pointLight = frame.pointLight;
+         setSelected(list, false);
+         // fog starts closer to the camera on the buildings
+         const float buildingFogNear = 0.001f;
+         auto building = [&](const glm::vec3 &offset) {
+           return Instance{buildingTransform(scene, offset),
+                           buildingTransform(previousScene, offset)};
+         };
+
+         // zgrada 1 [POCETAK]
+         pointLight.position = glm::vec3(4.0 * cos(frame.time), 15.0f,
+                                         15.0 * sin(frame.time));
+         recordLit(list, litPrograms, rb1Model,
+                   {building(glm::vec3(25.0, 0.0, 5.0))}, pointLight,
+                   frame.viewPosition, buildingFogNear);
+         // zgrada1 [KRAJ]
+
+         // zgrada2 [POCETAK]
+         pointLight.position = glm::vec3(4.0 * cos(frame.time), 4.0f,
+                                         4.0 * sin(frame.time));
+         recordLit(list, litPrograms, rb2Model,
+                   {building(glm::vec3(-25.0, 0.0, 5.0))}, pointLight,
+                   frame.viewPosition, buildingFogNear);
+         // zgrada2 [KRAJ]
+
+         // zgrada3 [POCETAK]
+         std::vector<Instance> rb3Instances;
+         for (int i = -200; i < 200; i += 30)
+           rb3Instances.push_back(building(glm::vec3(17.0, 0.0, 5.0 + i)));
+         for (int i = -200; i < 200; i += 30)
+           rb3Instances.push_back(building(glm::vec3(-15.0, 0.0, 5.0 + i)));
+         recordLit(list, litPrograms, rb3Model, rb3Instances, pointLight,
+                   frame.viewPosition, buildingFogNear);
+         // zgrada3 [KRAJ]
+
+         // zgrada4 [POCETAK]
+         recordLit(list, litPrograms, rb4Model,
+                   {building(glm::vec3(-85.0, 0.0, 5.0))}, pointLight,
+                   frame.viewPosition, buildingFogNear);
+         // zgrada4 [KRAJ]
+       }},
+      {"Roads", "Record Roads",
+       [&](rg::CommandList &list, const FrameSnapshot &frame) {
+         // PUT [POCETAK]
+         setSelected(list, false);
+         PointLight pointLight = frame.pointLight;
+         pointLight.position = glm::vec3(4.0 * cos(frame.time), 4.0f,
+                                         4.0 * sin(frame.time));
+
+         std::vector<Instance> roads;
+         for (int i = 0; i < 10; i++) {
+           glm::vec3 roadOffset(0.0, -1.4, -i * 41.5);
+           roads.push_back({roadTransform(frame.scene, roadOffset),
+                            roadTransform(previousScene, roadOffset)});
+         }
+         for (int i = 0; i < 10; i++) {
+           glm::vec3 roadOffset(0.0, -1.4, i * 41.5);
+           roads.push_back({roadTransform(frame.scene, roadOffset),
+                            roadTransform(previousScene, roadOffset)});
+         }
+         recordLit(list, litPrograms, roadModel, roads, pointLight,
+                   frame.viewPosition);
+         // PUT [KRAJ]
+       }},
+      {"Windows", "Record Windows",
+       [&](rg::CommandList &list, const FrameSnapshot &frame) {
+         // blending and depth writes are set up by WeightedBlendedOIT, the
+         // panes are drawn in any order with depth testing on
+         list.use(windowsProgram);
+
+         // glass leaves the selection mask of what is behind it alone
+         list.stencilMask(0x00);
+         list.disable(GL_CULL_FACE);
+         for (int i = 0; i < 5; i++) {
+           glm::mat4 model = windowTransform(frame.scene, i);
+           list.setMat4("model", model);
+           windowsModel.Record(list);
+           for (const Mesh &mesh : windowsModel.meshes)
+             if (mesh.material)
+               requestMips(*mesh.material, mesh, model);
+         }
+         list.enable(GL_CULL_FACE);
+         list.stencilMask(0xFF);
+       },
+       true},
+  };
+  rg::CommandReplayer commandReplayer;
+
+  auto renderFrame = [&](FrameSnapshot &frame) {
+    profiler.Detailed = frame.detailedProfiling;
+    if (frame.captureFrames > 0)
+      profiler.requestCapture(frame.captureFrames, "trace.json");
+    profiler.beginFrame();
+    // edited shaders are swapped in before anything records or draws with them
+    shaderReloader.update();
+    // parameters of materials added or changed since the last frame
+    rg::materials().upload();
+    frameData.beginFrame();
+    rg::drawStats().reset();
+    glState.resetStats();
+    if (benchmarking)
+      benchmark.recordProfile(profiler);
+    if (regressionTesting)
+      regression.recordProfile(profiler);
+
+    glClearColor(pow(frame.clearColor.r, gamma), pow(frame.clearColor.g, gamma),
+                 pow(frame.clearColor.b, gamma), 1.0f);
 
     // Specify the color of the background
 
     // render
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    // storage only follows the window size, the scale just moves the viewport
+    sceneTarget.resize(frame.width, frame.height);
+    dynamicResolution.Enabled = frame.dynamicResolution;
+    dynamicResolution.TargetMs = frame.gpuBudgetMs;
+    dynamicResolution.MinScale = frame.minRenderScale;
+    sceneTarget.setScale(dynamicResolution.scale());
+    taa.Enabled = frame.temporalAA;
+    taa.Feedback = frame.taaFeedback;
+    taa.resize(frame.width, frame.height);
+    float aspectRatio = (float)frame.width / (float)std::max(frame.height, 1);
+
+    SceneParams scene = frame.scene;
+    if (firstFrame)
+      previousScene = scene;
+
+    // the footprints the passes report are measured from this camera
+    rg::TextureStreamer &textureStreamer = rg::textureStreamer();
+    textureStreamer.setBudget(frame.textureBudget);
+    textureStreamer.beginFrame(frame.viewPosition, glm::radians(frame.zoom),
+                               sceneTarget.viewportHeight());
+
+    // Scene passes record on the workers while this thread sets up the frame
+    // and draws the skybox.
+    rg::JobSystem &jobs = rg::jobs();
+    rg::JobCounter recording;
+    for (ScenePass &pass : scenePasses) {
+      jobs.run(
+          pass.jobName,
+          [&pass, &frame] {
+            pass.commands.reset();
+            pass.record(pass.commands, frame);
+          },
+          &recording);
+    }
+
+    // Shared camera matrices. With TAA on, the projection used for rasterization
+    // is jittered by a sub-pixel amount every frame; the velocity buffer is
+    // computed from the unjittered matrices.
+    glm::vec2 jitter(0.0f);
+    if (taa.Enabled)
+      jitter = taa.nextJitter(sceneTarget.viewportWidth(),
+                              sceneTarget.viewportHeight());
+    FrameCamera frameCamera;
+    frameCamera.view = frame.view;
+    glm::mat4 unjitteredProjection = glm::perspective(
+        glm::radians(frame.zoom), aspectRatio, 0.1f, 1000.0f);
+    frameCamera.projection =
+        rg::TemporalAA::jitterProjection(unjitteredProjection, jitter);
+    frameCamera.viewProjection = unjitteredProjection * frameCamera.view;
+    frameCamera.prevViewProjection =
+        firstFrame ? frameCamera.viewProjection : previousViewProjection;
+    rg::FrameAllocation cameraBlock = frameData.write(frameCamera);
+    frameData.flush();
+    frameData.bindRange(GL_UNIFORM_BUFFER, kCameraBlockBinding, cameraBlock);
+
+    int antiAliasing = frame.antiAliasing;
+    bool msaa = antiAliasing == AA_MSAA_4X;
+    if (msaa) {
+      msaaTarget.resize(frame.width, frame.height);
+      msaaTarget.setScale(sceneTarget.scale());
+    } else if (msaaTarget.width() > 0) {
+      msaaTarget.destroy();
+    }
+    rg::RenderTarget &renderTarget = msaa ? msaaTarget : sceneTarget;
+
+    profiler.beginScope("Scene", rg::ProfileKind::Span);
+    renderTarget.bind();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
+    glState.enable(GL_CULL_FACE);
+    glState.enable(GL_DEPTH_TEST);
     // SKYBOX [POCETAK]
-    glDepthFunc(GL_LEQUAL);
+    profiler.beginScope("Skybox");
+    glState.stencilFunc(GL_ALWAYS, 0, 0xFF);
+    glState.depthFunc(GL_LEQUAL);
     skyboxShader.use();
-    glm::mat4 skyboxView = glm::mat4(1.0f);
-    glm::mat4 skyboxProjection = glm::mat4(1.0f);
-    skyboxView = glm::mat4(glm::mat3(
-        glm::lookAt(programState->camera.Position,
-                    programState->camera.Position + programState->camera.Front,
-                    programState->camera.Up)));
-    skyboxProjection = glm::perspective(
-        glm::radians(45.0f), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 1000.0f);
-    glUniformMatrix4fv(glGetUniformLocation(skyboxShader.ID, "view"), 1,
-                       GL_FALSE, glm::value_ptr(skyboxView));
-    glUniformMatrix4fv(glGetUniformLocation(skyboxShader.ID, "projection"), 1,
-                       GL_FALSE, glm::value_ptr(skyboxProjection));
-
-    glBindVertexArray(skyboxVAO);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+    glm::mat4 skyboxView = glm::mat4(glm::mat3(frameCamera.view));
+    glm::mat4 skyboxProjection = glm::perspective(
+        glm::radians(45.0f), aspectRatio, 0.1f, 1000.0f);
+    glm::mat4 skyboxViewProjection = skyboxProjection * skyboxView;
+    skyboxShader.setMat4("view", skyboxView);
+    skyboxShader.setMat4(
+        "projection", rg::TemporalAA::jitterProjection(skyboxProjection, jitter));
+    skyboxShader.setMat4("currViewProjection", skyboxViewProjection);
+    skyboxShader.setMat4("prevViewProjection",
+                         firstFrame ? skyboxViewProjection
+                                    : previousSkyboxViewProjection);
+
+    glState.bindVertexArray(skyboxVAO);
+    glState.bindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
     glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    rg::countDraw(GL_TRIANGLES, 36);
 
-    glDepthFunc(GL_LESS);
+    glState.depthFunc(GL_LESS);
 
+    profiler.endScope();
     // SKYBOX [KRAJ]
 
-    // KOBRA [POCETAK]
-    // Namestanje svetla za shader kobre
-    cobraShader.use();
-    pointLight.position =
-        glm::vec3(10.0 * cos(currentFrame), 10.0f, 70.0 * sin(currentFrame));
-    cobraShader.setVec3("pointLight.position", pointLight.position);
-    cobraShader.setVec3("pointLight.ambient", pointLight.ambient);
-    cobraShader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    cobraShader.setVec3("pointLight.specular", pointLight.specular);
-    cobraShader.setFloat("pointLight.constant", pointLight.constant);
-    cobraShader.setFloat("pointLight.linear", pointLight.linear);
-    cobraShader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    cobraShader.setVec3("viewPosition", programState->camera.Position);
-    cobraShader.setFloat("material.shininess", 32.0f);
-
-    // transformacije modela kobre
-    glm::mat4 cobraProjection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 cobraView = programState->camera.GetViewMatrix();
-    cobraShader.setMat4("projection", cobraProjection);
-    cobraShader.setMat4("view", cobraView);
-
-    // crtanje modela Shelby kobre
-    glm::mat4 cobraTransform = glm::mat4(1.0f);
-    cobraTransform = glm::translate(
-        cobraTransform,
-        programState->backpackPosition); // translate it down so it's at the
-                                         // center of the scene
-    cobraTransform = glm::scale(
-        cobraTransform,
-        glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                 // scene, so scale it down
-    cobraShader.setMat4("model", cobraTransform);
-
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
-    glStencilMask(0xFF);
-    cobraModel.Draw(cobraShader);
-
-    // TODO: Ukloniti stencil bafer
-
-    // Stencil buffer
-
-    // STENCIL MODE KOBRA
-
-    // KOBRA [KRAJ]
-
-    // zgrada 1 [POCETAK]
-    rb1Shader.use();
-    pointLight.position =
-        glm::vec3(4.0 * cos(currentFrame), 15.0f, 15.0 * sin(currentFrame));
-    rb1Shader.setVec3("pointLight.position", pointLight.position);
-    rb1Shader.setVec3("pointLight.ambient", pointLight.ambient);
-    rb1Shader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    rb1Shader.setVec3("pointLight.specular", pointLight.specular);
-    rb1Shader.setFloat("pointLight.constant", pointLight.constant);
-    rb1Shader.setFloat("pointLight.linear", pointLight.linear);
-    rb1Shader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    rb1Shader.setVec3("viewPosition", programState->camera.Position);
-    rb1Shader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 rb1Projection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 rb1View = programState->camera.GetViewMatrix();
-    rb1Shader.setMat4("projection", rb1Projection);
-    rb1Shader.setMat4("view", rb1View);
-
-    glm::mat4 rb1Transform = glm::mat4(1.0f);
-    rb1Transform = glm::translate(
-        rb1Transform,
-        programState->backpackPosition +
-            glm::vec3(
-                25.0, 0.0,
-                5.0)); // translate it down so it's at the center of the scene
-    rb1Transform = glm::scale(
-        rb1Transform,
-        glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                 // scene, so scale it down
-    rb1Shader.setMat4("model", rb1Transform);
-    rb1Model.Draw(rb1Shader);
-    // zgrada1 [KRAJ]
-
-    // zgrada2 [POCETAK]
-    rb2Shader.use();
-    pointLight.position =
-        glm::vec3(4.0 * cos(currentFrame), 4.0f, 4.0 * sin(currentFrame));
-    rb2Shader.setVec3("pointLight.position", pointLight.position);
-    rb2Shader.setVec3("pointLight.ambient", pointLight.ambient);
-    rb2Shader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    rb2Shader.setVec3("pointLight.specular", pointLight.specular);
-    rb2Shader.setFloat("pointLight.constant", pointLight.constant);
-    rb2Shader.setFloat("pointLight.linear", pointLight.linear);
-    rb2Shader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    rb2Shader.setVec3("viewPosition", programState->camera.Position);
-    rb2Shader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 rb2Projection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 rb2View = programState->camera.GetViewMatrix();
-    rb2Shader.setMat4("projection", rb2Projection);
-    rb2Shader.setMat4("view", rb2View);
-
-    glm::mat4 rb2Transform = glm::mat4(1.0f);
-    rb2Transform = glm::translate(
-        rb2Transform,
-        programState->backpackPosition +
-            glm::vec3(
-                -25.0, 0.0,
-                5.0)); // translate it down so it's at the center of the scene
-    rb2Transform = glm::scale(
-        rb2Transform,
-        glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                 // scene, so scale it down
-    rb2Shader.setMat4("model", rb2Transform);
-    rb2Model.Draw(rb2Shader);
-    // zgrada2 [KRAJ]
-
-    // zgrada3 [POCETAK]
-    rb3Shader.use();
-    pointLight.position =
-        glm::vec3(4.0 * cos(currentFrame), 4.0f, 4.0 * sin(currentFrame));
-    rb3Shader.setVec3("pointLight.position", pointLight.position);
-    rb3Shader.setVec3("pointLight.ambient", pointLight.ambient);
-    rb3Shader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    rb3Shader.setVec3("pointLight.specular", pointLight.specular);
-    rb3Shader.setFloat("pointLight.constant", pointLight.constant);
-    rb3Shader.setFloat("pointLight.linear", pointLight.linear);
-    rb3Shader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    rb3Shader.setVec3("viewPosition", programState->camera.Position);
-    rb3Shader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 rb3Projection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 rb3View = programState->camera.GetViewMatrix();
-    rb3Shader.setMat4("projection", rb3Projection);
-    rb3Shader.setMat4("view", rb3View);
-
-    for (int i = -200; i < 200; i += 30) {
-      glm::mat4 rb3Transform = glm::mat4(1.0f);
-      rb3Transform = glm::translate(
-          rb3Transform,
-          programState->backpackPosition +
-              glm::vec3(17.0, 0.0, 5.0 + i)); // translate it down so it's at
-                                              // the center of the scene
-      rb3Transform = glm::scale(
-          rb3Transform,
-          glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                   // scene, so scale it down
-      rb3Shader.setMat4("model", rb3Transform);
-      rb3Model.Draw(rb3Shader);
-    }
-
-    for (int i = -200; i < 200; i += 30) {
-      glm::mat4 rb3Transform = glm::mat4(1.0f);
-      rb3Transform = glm::translate(
-          rb3Transform,
-          programState->backpackPosition +
-              glm::vec3(-15.0, 0.0, 5.0 + i)); // translate it down so it's at
-                                               // the center of the scene
-      rb3Transform = glm::scale(
-          rb3Transform,
-          glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                   // scene, so scale it down
-      rb3Shader.setMat4("model", rb3Transform);
-      rb3Model.Draw(rb3Shader);
+    // KOBRA, ZGRADE, PUT I PROZORI [POCETAK]
+    jobs.wait(recording);
+    // levels that arrived are swapped in before the replay samples them, the
+    // ones the recording asked for start loading
+    textureStreamer.update();
+    oit.prepare(renderTarget);
+    commandReplayer.begin();
+    for (ScenePass &pass : scenePasses) {
+      profiler.beginScope(pass.name);
+      if (pass.transparent)
+        oit.beginAccumulate();
+      commandReplayer.execute(pass.commands);
+      if (pass.transparent) {
+        oit.endAccumulate();
+        // average of the transparent layers over the opaque scene; stencil
+        // is left alone for the selection outline
+        profiler.beginScope("OIT composite");
+        oitCompositeShader.use();
+        glState.bindTexture(0, GL_TEXTURE_2D, oit.accumulationTexture());
+        glState.bindTexture(1, GL_TEXTURE_2D, oit.weightTexture());
+        glState.disable(GL_CULL_FACE);
+        glState.disable(GL_DEPTH_TEST);
+        glState.disable(GL_STENCIL_TEST);
+        glState.enable(GL_BLEND);
+        glState.bindVertexArray(rectVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        rg::countDraw(GL_TRIANGLES, 6);
+        glState.disable(GL_BLEND);
+        glState.enable(GL_STENCIL_TEST);
+        glState.enable(GL_DEPTH_TEST);
+        glState.enable(GL_CULL_FACE);
+        profiler.endScope();
+      }
+      profiler.endScope();
     }
-    // zgrada3 [KRAJ]
-
-    // zgrada4 [POCETAK]
-    rb4Shader.use();
-    pointLight.position =
-        glm::vec3(4.0 * cos(currentFrame), 4.0f, 4.0 * sin(currentFrame));
-    rb4Shader.setVec3("pointLight.position", pointLight.position);
-    rb4Shader.setVec3("pointLight.ambient", pointLight.ambient);
-    rb4Shader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    rb4Shader.setVec3("pointLight.specular", pointLight.specular);
-    rb4Shader.setFloat("pointLight.constant", pointLight.constant);
-    rb4Shader.setFloat("pointLight.linear", pointLight.linear);
-    rb4Shader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    rb4Shader.setVec3("viewPosition", programState->camera.Position);
-    rb4Shader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 rb4Projection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 rb4View = programState->camera.GetViewMatrix();
-    rb4Shader.setMat4("projection", rb4Projection);
-    rb4Shader.setMat4("view", rb4View);
-
-    glm::mat4 rb4Transform = glm::mat4(1.0f);
-    rb4Transform = glm::translate(
-        rb4Transform,
-        programState->backpackPosition +
-            glm::vec3(
-                -85.0, 0.0,
-                5.0)); // translate it down so it's at the center of the scene
-    rb4Transform = glm::scale(
-        rb4Transform,
-        glm::vec3(programState->backpackScale)); // it's a bit too big for our
-                                                 // scene, so scale it down
-    rb4Shader.setMat4("model", rb4Transform);
-    rb4Model.Draw(rb1Shader);
-    // zgrada4 [KRAJ]
-
-    // PUT [POCETAK]
-    roadShader.use();
-    pointLight.position =
-        glm::vec3(4.0 * cos(currentFrame), 4.0f, 4.0 * sin(currentFrame));
-    roadShader.setVec3("pointLight.position", pointLight.position);
-    roadShader.setVec3("pointLight.ambient", pointLight.ambient);
-    roadShader.setVec3("pointLight.diffuse", pointLight.diffuse);
-    roadShader.setVec3("pointLight.specular", pointLight.specular);
-    roadShader.setFloat("pointLight.constant", pointLight.constant);
-    roadShader.setFloat("pointLight.linear", pointLight.linear);
-    roadShader.setFloat("pointLight.quadratic", pointLight.quadratic);
-    roadShader.setVec3("viewPosition", programState->camera.Position);
-    roadShader.setFloat("material.shininess", 32.0f);
-
-    glm::mat4 roadProjection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 roadView = programState->camera.GetViewMatrix();
-    roadShader.setMat4("projection", roadProjection);
-    roadShader.setMat4("view", roadView);
-
-    for (int i = 0; i < 10; i++) {
-      glm::mat4 roadTransform = glm::mat4(1.0f);
-
-      roadTransform = glm::translate(
-          roadTransform,
-          programState->backpackPosition +
-              glm::vec3(0.0, -1.4, -i * 41.5)); // translate it down so it's at
-                                                // the center of the scene
-      roadTransform = glm::scale(
-          roadTransform,
-          glm::vec3(programState->backpackScale *
-                    5.0)); // it's a bit too big for our scene, so scale it down
-      roadShader.setMat4("model", roadTransform);
-      roadModel.Draw(roadShader);
+    // KOBRA, ZGRADE, PUT I PROZORI [KRAJ]
+
+    previousScene = scene;
+    previousViewProjection = frameCamera.viewProjection;
+    previousSkyboxViewProjection = skyboxViewProjection;
+    firstFrame = false;
+    profiler.endScope();
+
+    if (msaa) {
+      profiler.beginScope("AA", rg::ProfileKind::Span);
+      profiler.beginScope("MSAA resolve");
+      msaaTarget.resolveTo(sceneTarget);
+      profiler.endScope();
+      profiler.endScope();
     }
 
-    for (int i = 0; i < 10; i++) {
-      glm::mat4 roadTransform = glm::mat4(1.0f);
-
-      roadTransform = glm::translate(
-          roadTransform,
-          programState->backpackPosition +
-              glm::vec3(0.0, -1.4, i * 41.5)); // translate it down so it's at
-                                               // the center of the scene
-      roadTransform = glm::scale(
-          roadTransform,
-          glm::vec3(programState->backpackScale *
-                    5.0)); // it's a bit too big for our scene, so scale it down
-      roadShader.setMat4("model", roadTransform);
-      roadModel.Draw(roadShader);
+    profiler.beginScope("Post", rg::ProfileKind::Span);
+    glState.disable(GL_CULL_FACE);
+    // prevents framebuffer rectangle from being discarded
+    glState.disable(GL_DEPTH_TEST);
+    glState.bindVertexArray(rectVAO);
+
+    // OBRIS [POCETAK]
+    // Jump flooded from the resolved stencil of the selected objects, then
+    // blended over the scene before it is resolved by TAA.
+    profiler.beginScope("Outline");
+    selectionOutline.prepare(sceneTarget);
+    selectionOutline.beginSeeds();
+    outlineSeedShader.use();
+    glState.stencilFunc(GL_EQUAL, kSelectionStencil, 0xFF);
+    glState.stencilMask(0x00);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    rg::countDraw(GL_TRIANGLES, 6);
+    glState.stencilMask(0xFF);
+    glState.stencilFunc(GL_ALWAYS, 0, 0xFF);
+    glState.disable(GL_STENCIL_TEST);
+
+    outlineFloodShader.use();
+    for (int step : selectionOutline.floodSteps()) {
+      unsigned int seeds = selectionOutline.beginFloodPass();
+      glState.bindTexture(0, GL_TEXTURE_2D, seeds);
+      outlineFloodShader.setInt("stepSize", step);
+      glDrawArrays(GL_TRIANGLES, 0, 6);
+      rg::countDraw(GL_TRIANGLES, 6);
     }
 
-    // WINDOWS
-    windowsShader.use();
-    glm::mat4 windowsProjection =
-        glm::perspective(glm::radians(programState->camera.Zoom),
-                         (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
-    glm::mat4 windowsView = programState->camera.GetViewMatrix();
-    roadShader.setMat4("projection", windowsProjection);
-    roadShader.setMat4("view", windowsView);
-
-    glm::mat4 windowTransform = glm::mat4(1.0f);
-
-    windowTransform = glm::translate(
-        windowTransform,
-        programState->backpackPosition +
-            glm::vec3(
-                0.0, 5.0,
-                0.0)); // translate it down so it's at the center of the scene
-
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
-    for (int i = 0; i < 5; i++) {
-      windowTransform = glm::mat4(1.0f);
-      windowTransform =
-          glm::translate(windowTransform, programState->backpackPosition +
-                                              glm::vec3(0.0, 3.0, i * 4));
-      windowTransform = glm::scale(
-          windowTransform,
-          glm::vec3(programState->backpackScale *
-                    5.0)); // it's a bit too big for our scene, so scale it down
-      windowTransform =
-          glm::rotate(windowTransform, glm::radians(cos(currentFrame) * 180),
-                      glm::vec3(0, 1, 0));
-      windowsShader.setMat4("model", windowTransform);
-
-      windowsModel.Draw(windowsShader);
+    sceneTarget.bind();
+    outlineCompositeShader.use();
+    outlineCompositeShader.setVec3("color", selectionOutline.Color);
+    outlineCompositeShader.setFloat("width", (float)selectionOutline.Width);
+    glState.bindTexture(0, GL_TEXTURE_2D, selectionOutline.result());
+    glState.enable(GL_BLEND);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    rg::countDraw(GL_TRIANGLES, 6);
+    glState.disable(GL_BLEND);
+    glState.enable(GL_STENCIL_TEST);
+    profiler.endScope();
+    // OBRIS [KRAJ]
+
+    // TAA [POCETAK]
+    // Resolve the jittered, possibly reduced resolution frame against the
+    // reprojected history into a native resolution target.
+    unsigned int resolvedTexture = sceneTarget.colorTexture();
+    glm::vec2 resolvedUvScale = sceneTarget.uvScale();
+    if (taa.Enabled) {
+      profiler.beginScope("TAA");
+      taa.output().bind();
+      taaShader.use();
+      taaShader.setVec2("uvScale", glm::vec2(1.0f));
+      taaShader.setVec2("currentUvScale", sceneTarget.uvScale());
+      taaShader.setBool("historyValid", taa.historyValid());
+      taaShader.setFloat("feedback", taa.Feedback);
+      glState.bindTexture(0, GL_TEXTURE_2D, sceneTarget.colorTexture());
+      glState.bindTexture(1, GL_TEXTURE_2D, sceneTarget.colorTexture(1));
+      glState.bindTexture(2, GL_TEXTURE_2D, taa.history().colorTexture());
+      glDrawArrays(GL_TRIANGLES, 0, 6);
+      rg::countDraw(GL_TRIANGLES, 6);
+
+      resolvedTexture = taa.output().colorTexture();
+      resolvedUvScale = glm::vec2(1.0f);
+      taa.swap();
+      profiler.endScope();
+    } else {
+      taa.invalidate();
     }
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-    glEnable(GL_CULL_FACE);
-    // WINDOWS
-
-    // PUT [KRAJ]
-
-    // POCETAK KOBRA [STENCIL]
-    glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-    glStencilMask(0x00);
-    glDisable(GL_DEPTH_TEST);
-    cobraOutlineShader.use();
-    cobraOutlineShader.setFloat("str", 0.08f);
-    cobraOutlineShader.setMat4("projection", cobraProjection);
-    cobraOutlineShader.setMat4("view", cobraView);
-    cobraOutlineShader.setMat4("model", cobraTransform);
-    cobraModel.Draw(cobraOutlineShader);
-    glStencilMask(0xFF);
-    glStencilFunc(GL_ALWAYS, 0, 0xFF);
-    glEnable(GL_DEPTH_TEST);
-    // KRAJ KOBRA [STENCIL]
+    // TAA [KRAJ]
 
     // FRAMEBUFFER
+    // With FXAA the tonemapped image goes to an intermediate target first
+    bool fxaa = antiAliasing == AA_FXAA;
+    profiler.beginScope("Tonemap");
     framebufferShader.use();
-    glDisable(GL_CULL_FACE);
-    // glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDisable(
-        GL_DEPTH_TEST); // prevents framebuffer rectangle from being discarded
-    // Draw the framebuffer rectangle
-
-    glBindVertexArray(rectVAO);
-    glBindTexture(GL_TEXTURE_2D, framebufferTexture);
+    if (fxaa) {
+      ldrTarget.resize(frame.width, frame.height);
+      ldrTarget.bind();
+    } else {
+      if (ldrTarget.width() > 0)
+        ldrTarget.destroy();
+      glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
+      glState.viewport(0, 0, frame.width, frame.height);
+    }
+    // Draw the framebuffer rectangle, upscaling the rendered sub-rectangle
+    framebufferShader.setVec2("uvScale", resolvedUvScale);
+
+    glState.bindTexture(0, GL_TEXTURE_2D, resolvedTexture);
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    rg::countDraw(GL_TRIANGLES, 6);
+    profiler.endScope();
+    profiler.endScope();
+
+    // FXAA [POCETAK]
+    if (!msaa) {
+      profiler.beginScope("AA", rg::ProfileKind::Span);
+      if (fxaa) {
+        profiler.beginScope("FXAA");
+        glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState.viewport(0, 0, frame.width, frame.height);
+        fxaaShader.use();
+        fxaaShader.setVec2("uvScale", glm::vec2(1.0f));
+        glState.bindTexture(0, GL_TEXTURE_2D, ldrTarget.colorTexture());
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        rg::countDraw(GL_TRIANGLES, 6);
+        profiler.endScope();
+      }
+      profiler.endScope();
+    }
+    // FXAA [KRAJ]
+
+    // the finished frame, without UI, is in the back buffer now
+    if (regressionTesting)
+      regression.checkImage(frame.frameIndex, frame.width, frame.height);
 
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
+    glState.enable(GL_CULL_FACE);
+    glState.enable(GL_DEPTH_TEST);
 
     // GUI crtanje
-    if (programState->ImGuiEnabled)
-      DrawImGui(programState);
+    profiler.beginScope("UI", rg::ProfileKind::Span);
+    if (frame.ui.drawData.Valid) {
+      profiler.beginScope("ImGui");
+      ImGui_ImplOpenGL3_RenderDrawData(&frame.ui.drawData);
+      // the backend restores what it changes, but bypassing the shadow
+      glState.invalidate();
+      profiler.endScope();
+    }
+    profiler.endScope();
+
+    // each measured frame once: the last result stays around while late ones
+    // are skipped
+    if (profiler.hasResult() &&
+        (int)profiler.completedFrame() != lastProfiledFrame) {
+      lastProfiledFrame = (int)profiler.completedFrame();
+      double frameMs = profiler.lastGpuFrameMs();
+      dynamicResolution.update(frameMs);
+      // exponential moving averages so the modes can be compared side by side
+      float &aaFrame = renderedStats.aaFrameMs[antiAliasing];
+      float &aaStage = renderedStats.aaStageMs[antiAliasing];
+      aaFrame += (frameMs - aaFrame) * 0.05f;
+      aaStage += (profiler.lastGpuMs("AA") - aaStage) * 0.05f;
+    }
 
-    // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved
-    // etc.)
+    // glfw: swap buffers, the main thread polls IO events
     // -------------------------------------------------------------------------------
+    frameData.endFrame();
     glfwSwapBuffers(window);
+    profiler.endFrame();
+
+    double swapTime = glfwGetTime();
+    if (benchmarking)
+      benchmark.recordFrame(frame.frameIndex,
+                            (swapTime - lastSwapTime) * 1000.0,
+                            rg::drawStats());
+    if (regressionTesting)
+      regression.recordFrame(frame.frameIndex, rg::drawStats());
+    lastSwapTime = swapTime;
+
+    // numbers for the UI of the next frames
+    RenderStats &stats = renderedStats;
+    stats.renderScale = dynamicResolution.scale();
+    stats.dynamicResolutionGpuMs = dynamicResolution.lastGpuMs();
+    stats.cpuFrameMs = profiler.lastCpuFrameMs();
+    stats.gpuFrameMs = profiler.lastGpuFrameMs();
+    std::copy(profiler.cpuHistory(),
+              profiler.cpuHistory() + rg::Profiler::kHistory,
+              stats.cpuHistory);
+    std::copy(profiler.gpuHistory(),
+              profiler.gpuHistory() + rg::Profiler::kHistory,
+              stats.gpuHistory);
+    stats.historyOffset = profiler.historyOffset();
+    stats.capturing = profiler.capturing();
+    stats.glState = glState.stats();
+    stats.textureStreaming = textureStreamer.stats();
+    stats.passes.clear();
+    for (const rg::ProfileRecord &record : profiler.lastFrame())
+      stats.passes.push_back(
+          {record.name, record.depth, profiler.stats(record.name)});
+    std::lock_guard<std::mutex> lock(renderStatsMutex);
+    renderStats = stats;
+  };
+
+  // the context can only be current on one thread at a time
+  glfwMakeContextCurrent(nullptr);
+  std::thread renderThread([&]() {
+    glfwMakeContextCurrent(window);
+    profiler.setThreadName("Render");
+    while (FrameSnapshot *frame = frames.acquire()) {
+      // frames still queued when a headless run completes are dropped
+      if (!renderFinished) {
+        renderFrame(*frame);
+        renderFinished = (benchmarking && benchmark.done()) ||
+                         (regressionTesting && regression.done());
+      }
+      frames.release();
+    }
+    glfwMakeContextCurrent(nullptr);
+  });
+  // before the first frame is published, the queue orders it for the thread
+  profiler.setRenderThread(renderThread.get_id());
+
+  int frameIndex = 0;
+  while (!glfwWindowShouldClose(window) && !renderFinished) {
+    // per-frame time logic
+    // --------------------
+    // benchmarks advance the scene by a fixed step so every run is identical,
+    // regression poses freeze it
+    float currentFrame = glfwGetTime();
+    if (benchmarking)
+      currentFrame = benchmark.sceneTime(frameIndex);
+    else if (regressionTesting)
+      currentFrame = regression.pose(frameIndex).camera.time;
+    deltaTime = currentFrame - lastFrame;
+    // a replay substitutes the recorded time steps
+    if (!inputRecorder.beginFrame(currentFrame, deltaTime))
+      break;
+    lastFrame = currentFrame;
+
+    // input
+    // -----
+    if (headless) {
+      rg::CameraKeyframe pose =
+          benchmarking ? benchmark.cameraAt(currentFrame)
+                       : regression.pose(frameIndex).camera;
+      programState->camera =
+          Camera(pose.position, glm::vec3(0.0f, 1.0f, 0.0f), pose.yaw,
+                 pose.pitch);
+    } else {
+      processInput(window);
+    }
+
+    // GUI layout, drawn by the render thread with the rest of the frame
+    if (programState->ImGuiEnabled) {
+      RenderStats uiStats;
+      {
+        std::lock_guard<std::mutex> lock(renderStatsMutex);
+        uiStats = renderStats;
+      }
+      DrawImGui(programState, uiStats);
+    }
+
+    // waits while the render thread is two frames behind
+    FrameSnapshot *frame = frames.beginWrite();
+    if (frame == nullptr)
+      break;
+    frame->frameIndex = frameIndex;
+    frame->time = currentFrame;
+    frame->width = windowWidth;
+    frame->height = windowHeight;
+    frame->clearColor = programState->clearColor;
+    frame->view = programState->camera.GetViewMatrix();
+    frame->viewPosition = programState->camera.Position;
+    frame->zoom = programState->camera.Zoom;
+    frame->scene.origin = programState->backpackPosition;
+    frame->scene.scale = programState->backpackScale;
+    frame->scene.time = currentFrame;
+    frame->pointLight = programState->pointLight;
+    frame->dynamicResolution = programState->dynamicResolution.Enabled;
+    frame->gpuBudgetMs = programState->dynamicResolution.TargetMs;
+    frame->minRenderScale = programState->dynamicResolution.MinScale;
+    frame->temporalAA = programState->temporalAA.Enabled;
+    frame->taaFeedback = programState->temporalAA.Feedback;
+    frame->antiAliasing = programState->antiAliasing;
+    frame->textureBudget = (size_t)programState->textureBudgetMB << 20;
+    frame->detailedProfiling =
+        headless ||
+        (programState->ImGuiEnabled && programState->ProfilerWindowVisible);
+    frame->captureFrames = programState->captureFrames;
+    programState->captureFrames = 0;
+    if (programState->ImGuiEnabled)
+      frame->ui.capture(ImGui::GetDrawData());
+    else
+      frame->ui.clear();
+    frames.publish();
+
+    // glfw: poll IO events (keys pressed/released, mouse moved etc.)
+    // -------------------------------------------------------------------------------
     glfwPollEvents();
+    if (inputRecorder.replaying()) {
+      inputRecorder.dispatchEvents([window](const rg::InputEvent &event) {
+        if (event.type == rg::InputEventType::Key)
+          key_callback(window, event.key, 0, event.action, event.mods);
+        else if (event.type == rg::InputEventType::CursorPos)
+          mouse_callback(window, event.x, event.y);
+        else if (event.type == rg::InputEventType::Scroll)
+          scroll_callback(window, event.x, event.y);
+      });
+    }
+    frameIndex++;
   }
 
-  programState->SaveToFile("resources/program_state.txt");
+  // the render thread finishes the frames already handed to it
+  frames.close();
+  renderThread.join();
+  glfwMakeContextCurrent(window);
+
+  bool failed = (benchmarking && !benchmark.writeReport()) ||
+                (regressionTesting && !regression.finish());
+  if (!memoryReportPath.empty() && !memory.writeJson(memoryReportPath))
+    failed = true;
+
+  inputRecorder.stop();
+  // waits for its copy jobs, so before the workers go
+  rg::textureStreamer().destroy();
+  rg::jobs().shutdown();
+  rg::glDebug().printSummary();
+  profiler.destroy();
+  frameData.destroy();
+  sceneTarget.destroy();
+  msaaTarget.destroy();
+  ldrTarget.destroy();
+  taa.destroy();
+  oit.destroy();
+  selectionOutline.destroy();
+  for (Model *model : {&windowsModel, &cobraModel, &rb1Model, &rb2Model,
+                       &rb3Model, &rb4Model, &roadModel})
+    model->Destroy();
+  glDeleteVertexArrays(1, &skyboxVAO);
+  glState.vertexArrayDeleted(skyboxVAO);
+  glDeleteVertexArrays(1, &rectVAO);
+  glState.vertexArrayDeleted(rectVAO);
+  for (unsigned int buffer : {skyboxVBO, skyboxEBO, rectVBO}) {
+    glDeleteBuffers(1, &buffer);
+    glState.bufferDeleted(buffer);
+    memory.bufferDeleted(buffer);
+  }
+  glDeleteTextures(1, &cubemapTexture);
+  glState.textureDeleted(cubemapTexture);
+  memory.textureDeleted(cubemapTexture);
+  rg::materials().destroy();
+  rg::pak().close();
+  // everything tracked is released by now
+  memory.reportLeaks();
+
+  if (!headless)
+    programState->SaveToFile("resources/program_state.txt");
   delete programState;
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
@@ -742,23 +1510,29 @@ auto main() -> int {
   // glfw: terminate, clearing all previously allocated GLFW resources.
   // ------------------------------------------------------------------
   glfwTerminate();
-  return 0;
+  return failed ? -1 : 0;
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this
 // frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
+bool keyPressed(GLFWwindow *window, int key) {
+  if (inputRecorder.replaying())
+    return inputRecorder.keyDown(key);
+  return glfwGetKey(window, key) == GLFW_PRESS;
+}
+
 void processInput(GLFWwindow *window) {
-  if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+  if (keyPressed(window, GLFW_KEY_ESCAPE))
     glfwSetWindowShouldClose(window, true);
 
-  if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+  if (keyPressed(window, GLFW_KEY_W))
     programState->camera.ProcessKeyboard(FORWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+  if (keyPressed(window, GLFW_KEY_S))
     programState->camera.ProcessKeyboard(BACKWARD, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+  if (keyPressed(window, GLFW_KEY_A))
     programState->camera.ProcessKeyboard(LEFT, deltaTime);
-  if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+  if (keyPressed(window, GLFW_KEY_D))
     programState->camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
@@ -766,14 +1540,19 @@ void processInput(GLFWwindow *window) {
 // function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow *window, int width, int height) {
-  // make sure the viewport matches the new window dimensions; note that width
-  // and height will be significantly larger than specified on retina displays.
-  glViewport(0, 0, width, height);
+  // note that width and height will be significantly larger than specified on
+  // retina displays. The size goes to the render thread with the next frame,
+  // which sets the viewport and resizes the offscreen targets.
+  windowWidth = width;
+  windowHeight = height;
 }
 
 // glfw: whenever the mouse moves, this callback is called
 // -------------------------------------------------------
 void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
+  if (!inputRecorder.acceptsLiveInput())
+    return;
+  inputRecorder.recordCursorPos(xpos, ypos);
   if (firstMouse) {
     lastX = xpos;
     lastY = ypos;
@@ -794,11 +1573,14 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos) {
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
+  if (!inputRecorder.acceptsLiveInput())
+    return;
+  inputRecorder.recordScroll(xoffset, yoffset);
   programState->camera.ProcessMouseScroll(yoffset);
 }
 
-void DrawImGui(ProgramState *programState) {
-  ImGui_ImplOpenGL3_NewFrame();
+// Lays the UI out on the main thread; the render thread draws the result.
+void DrawImGui(ProgramState *programState, const RenderStats &stats) {
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
 
@@ -819,6 +1601,31 @@ void DrawImGui(ProgramState *programState) {
                      0.05, 0.0, 1.0);
     ImGui::DragFloat("pointLight.quadratic",
                      &programState->pointLight.quadratic, 0.05, 0.0, 1.0);
+
+    rg::DynamicResolution &dr = programState->dynamicResolution;
+    ImGui::Checkbox("Dynamic resolution", &dr.Enabled);
+    ImGui::DragFloat("GPU budget (ms)", &dr.TargetMs, 0.1, 4.0, 50.0);
+    ImGui::DragFloat("Min scale", &dr.MinScale, 0.01, 0.25, 1.0);
+    ImGui::Text("Render scale: %.2f (GPU %.2f ms)", stats.renderScale,
+                stats.dynamicResolutionGpuMs);
+    ImGui::Checkbox("Temporal AA", &programState->temporalAA.Enabled);
+    ImGui::DragFloat("TAA feedback", &programState->temporalAA.Feedback, 0.01,
+                     0.0, 0.98);
+    ImGui::Combo("Anti-aliasing", &programState->antiAliasing,
+                 antiAliasingNames, AA_COUNT);
+    // switch modes with dynamic resolution off to compare at equal pixel count
+    for (int i = 0; i < AA_COUNT; i++)
+      ImGui::Text("%-8s frame %.2f ms, AA stage %.2f ms", antiAliasingNames[i],
+                  stats.aaFrameMs[i], stats.aaStageMs[i]);
+    const rg::TextureStreamingStats &streaming = stats.textureStreaming;
+    ImGui::SliderInt("Texture budget (MiB)", &programState->textureBudgetMB,
+                     16, 2048);
+    ImGui::Text("Textures: %.1f of %.1f MiB resident, %zu streamed",
+                streaming.ResidentBytes / 1048576.0,
+                streaming.FullBytes / 1048576.0, streaming.Textures);
+    ImGui::Text("Mip levels: %zu loaded, %zu evicted, %zu in flight",
+                streaming.LevelsLoaded, streaming.LevelsEvicted,
+                streaming.LoadsInFlight);
     ImGui::End();
   }
 
@@ -831,15 +1638,122 @@ void DrawImGui(ProgramState *programState) {
     ImGui::Text("Camera front: (%f, %f, %f)", c.Front.x, c.Front.y, c.Front.z);
     ImGui::Checkbox("Camera mouse update",
                     &programState->CameraMouseMovementUpdateEnabled);
+    ImGui::Checkbox("Profiler", &programState->ProfilerWindowVisible);
+    ImGui::Checkbox("Memory", &programState->MemoryWindowVisible);
+    ImGui::End();
+  }
+
+  if (programState->MemoryWindowVisible)
+    DrawMemoryWindow(&programState->MemoryWindowVisible);
+
+  if (programState->ProfilerWindowVisible) {
+    ImGui::Begin("Profiler", &programState->ProfilerWindowVisible);
+    if (stats.capturing || programState->captureFrames > 0) {
+      ImGui::Text("Capturing trace...");
+    } else if (ImGui::Button("Capture 120 frames (F2)")) {
+      programState->captureFrames = 120;
+    }
+    ImGui::Text("Frame: CPU %.2f ms, GPU %.2f ms", stats.cpuFrameMs,
+                stats.gpuFrameMs);
+    ImGui::Text("GL state changes: %llu, %llu redundant dropped, %llu drifts",
+                stats.glState.calls, stats.glState.skipped,
+                stats.glState.drifts);
+    ImGui::PlotLines("CPU ms", stats.cpuHistory, rg::Profiler::kHistory,
+                     stats.historyOffset, nullptr, 0.0f, 33.3f, ImVec2(0, 60));
+    ImGui::PlotLines("GPU ms", stats.gpuHistory, rg::Profiler::kHistory,
+                     stats.historyOffset, nullptr, 0.0f, 33.3f, ImVec2(0, 60));
+    if (ImGui::BeginTable("passes", 3,
+                          ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+      ImGui::TableSetupColumn("Pass");
+      ImGui::TableSetupColumn("CPU ms");
+      ImGui::TableSetupColumn("GPU ms");
+      ImGui::TableHeadersRow();
+      for (const RenderStats::Pass &pass : stats.passes) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%*s%s", pass.depth * 2, "", pass.name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", pass.stats.cpuMs);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", pass.stats.gpuMs);
+      }
+      ImGui::EndTable();
+    }
     ImGui::End();
   }
 
   ImGui::Render();
-  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+}
+
+// what the tracked GPU and CPU resources hold, by category and owner, and the
+// largest allocations
+void DrawMemoryWindow(bool *open) {
+  const rg::MemoryTracker &memory = rg::memoryTracker();
+  const double MiB = 1024.0 * 1024.0;
+  ImGui::Begin("Memory", open);
+  std::vector<size_t> totals = memory.totals();
+  size_t gpu = 0, cpu = 0;
+  for (int i = 0; i < (int)rg::MemoryCategory::Count; i++)
+    (rg::isGpuCategory((rg::MemoryCategory)i) ? gpu : cpu) += totals[i];
+  ImGui::Text("GPU %.1f MiB, CPU %.1f MiB", gpu / MiB, cpu / MiB);
+  for (int i = 0; i < (int)rg::MemoryCategory::Count; i++)
+    ImGui::BulletText("%s: %.2f MiB",
+                      rg::memoryCategoryName((rg::MemoryCategory)i),
+                      totals[i] / MiB);
+  if (ImGui::Button("Write memory.json"))
+    memory.writeJson("memory.json");
+
+  ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+  if (ImGui::CollapsingHeader("Owners") &&
+      ImGui::BeginTable("owners", 2, flags)) {
+    ImGui::TableSetupColumn("Owner");
+    ImGui::TableSetupColumn("MiB");
+    ImGui::TableHeadersRow();
+    for (const auto &owner : memory.owners()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(owner.first.empty() ? "-" : owner.first.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", owner.second / MiB);
+    }
+    ImGui::EndTable();
+  }
+  if (ImGui::CollapsingHeader("Largest allocations",
+                              ImGuiTreeNodeFlags_DefaultOpen) &&
+      ImGui::BeginTable("allocations", 5, flags)) {
+    ImGui::TableSetupColumn("Resource");
+    ImGui::TableSetupColumn("Owner");
+    ImGui::TableSetupColumn("Category");
+    ImGui::TableSetupColumn("Format");
+    ImGui::TableSetupColumn("KiB");
+    ImGui::TableHeadersRow();
+    for (const rg::MemoryAllocation &a : memory.top(20)) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      if (a.Resource == rg::MemoryResource::Cpu)
+        ImGui::TextUnformatted(rg::memoryResourceName(a.Resource));
+      else
+        ImGui::Text("%s %llu", rg::memoryResourceName(a.Resource),
+                    (unsigned long long)a.Id);
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(a.Owner.empty() ? "-" : a.Owner.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(rg::memoryCategoryName(a.Category));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(rg::MemoryTracker::formatName(a.Format).c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", a.Bytes / 1024.0);
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
 }
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action,
                   int mods) {
+  if (!inputRecorder.acceptsLiveInput())
+    return;
+  inputRecorder.recordKey(key, action, mods);
   if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
     programState->ImGuiEnabled = !programState->ImGuiEnabled;
     if (programState->ImGuiEnabled) {
@@ -849,4 +1763,7 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action,
       glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
   }
+  if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+    programState->captureFrames = 120;
+  }
 }